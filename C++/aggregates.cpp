@@ -0,0 +1,143 @@
+// =============================================================================
+//  aggregates.cpp - 監視結果のローリング集計 (固定メモリ)
+// =============================================================================
+
+#include "aggregates.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+constexpr int64_t kWidths[3] = {5, 60, 3600};
+constexpr size_t kSlots[3] = {12, 60, 24};
+
+int64_t unix_sec(std::chrono::system_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+}
+}
+
+// =============================================================================
+RollingAggregates::RollingAggregates(const std::string& use_case,
+                                     std::vector<std::string> categories)
+    : m_use_case(use_case), m_categories(std::move(categories))
+{
+    m_categories.push_back("other");
+    for (int i = 0; i < 3; i++) {
+        m_rings[i].width = kWidths[i];
+        m_rings[i].slots.resize(kSlots[i]);
+        for (auto& b : m_rings[i].slots) {
+            b.start = -1;
+            b.counts.assign(m_categories.size(), 0);
+        }
+    }
+}
+
+size_t RollingAggregates::category_index(const std::string& c) const {
+    for (size_t i = 0; i + 1 < m_categories.size(); i++)
+        if (m_categories[i] == c) return i;
+    return m_categories.size() - 1;
+}
+
+void RollingAggregates::record(std::chrono::system_clock::time_point t,
+                               const std::vector<std::string>& categories,
+                               double latency_sec, bool error)
+{
+    const int64_t sec = unix_sec(t);
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (auto& ring : m_rings) {
+        const int64_t idx = sec / ring.width;
+        auto& b = ring.slots[(size_t)(idx % (int64_t)ring.slots.size())];
+        if (b.start > idx * ring.width) continue;   // 窓から外れた古い時刻
+        if (b.start != idx * ring.width) {
+            // 一周して古くなったバケットを再利用
+            b.start = idx * ring.width;
+            std::fill(b.counts.begin(), b.counts.end(), 0);
+            b.cycles = b.errors = 0;
+            b.latency_sum = 0.0;
+        }
+        b.cycles++;
+        b.latency_sum += latency_sec;
+        if (error) { b.errors++; continue; }
+        for (const auto& c : categories) b.counts[category_index(c)]++;
+    }
+}
+
+AggregateReport RollingAggregates::query(AggregateSpan span,
+                                         std::chrono::system_clock::time_point now) const
+{
+    AggregateReport r;
+    r.use_case = m_use_case;
+    r.span = span;
+    r.categories = m_categories;
+    r.counts.assign(m_categories.size(), 0);
+
+    const auto& ring = m_rings[(int)span];
+    r.bucket_sec = ring.width;
+    const int64_t newest = unix_sec(now) / ring.width * ring.width;
+    const int64_t oldest = newest - ring.width * ((int64_t)ring.slots.size() - 1);
+    double latency = 0.0;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (const auto& b : ring.slots)
+            if (b.start >= oldest && b.start <= newest && b.cycles > 0) r.buckets.push_back(b);
+    }
+    std::sort(r.buckets.begin(), r.buckets.end(),
+              [](const AggregateBucket& a, const AggregateBucket& b) { return a.start < b.start; });
+    for (const auto& b : r.buckets) {
+        for (size_t i = 0; i < b.counts.size(); i++) r.counts[i] += b.counts[i];
+        r.cycles += b.cycles;
+        r.errors += b.errors;
+        latency += b.latency_sum;
+    }
+    if (r.cycles) r.mean_latency = latency / r.cycles;
+    return r;
+}
+
+// =============================================================================
+const char* aggregate_span_name(AggregateSpan s) {
+    switch (s) {
+        case AggregateSpan::Minute: return "minute";
+        case AggregateSpan::Hour:   return "hour";
+        case AggregateSpan::Day:    return "day";
+    }
+    return "?";
+}
+
+std::string format_aggregate_summary(const AggregateReport& r) {
+    uint64_t answered = 0;
+    for (auto c : r.counts) answered += c;
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(0);
+    for (size_t i = 0; i < r.categories.size(); i++) {
+        if (r.counts[i] == 0 && i + 1 == r.categories.size()) continue;   // other = 0 は省略
+        double pct = answered ? 100.0 * r.counts[i] / answered : 0.0;
+        o << (i ? "  " : "") << r.categories[i] << " " << pct << "% (" << r.counts[i] << ")";
+    }
+    o << "  | " << r.cycles << " cycles";
+    if (r.errors) o << ", " << r.errors << " errors";
+    o << std::setprecision(2) << ", " << r.mean_latency << "s avg";
+    return o.str();
+}
+
+std::string format_aggregate_table(const AggregateReport& r) {
+    std::ostringstream o;
+    o << std::left << std::setw(8) << "  Time";
+    for (const auto& c : r.categories) o << std::right << std::setw(std::max<int>(8, (int)c.size() + 2)) << c;
+    o << std::setw(8) << "errors" << "\n";
+    for (const auto& b : r.buckets) {
+        std::time_t t = (std::time_t)b.start;
+        struct tm tmv;
+#ifdef _WIN32
+        localtime_s(&tmv, &t);
+#else
+        localtime_r(&t, &tmv);
+#endif
+        o << "  " << std::put_time(&tmv, r.bucket_sec >= 60 ? "%H:%M " : "%M:%S ");
+        for (size_t i = 0; i < b.counts.size(); i++)
+            o << std::right << std::setw(std::max<int>(8, (int)r.categories[i].size() + 2)) << b.counts[i];
+        o << std::setw(8) << b.errors << "\n";
+    }
+    return o.str();
+}
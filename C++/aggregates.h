@@ -0,0 +1,69 @@
+#pragma once
+// =============================================================================
+//  aggregates.h - 監視結果のローリング集計 (固定メモリ)
+//
+//  結果を 1 件ずつ流す代わりに、カテゴリ別の件数を時間バケットに積み上げ
+//  直近 1 分 / 1 時間 / 1 日の割合を安価に取り出せるようにする。
+//  バケットはリング状に再利用するので、稼働時間に関わらずメモリは一定:
+//    Minute: 5 秒 x 12   Hour: 1 分 x 60   Day: 1 時間 x 24
+// =============================================================================
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class AggregateSpan { Minute = 0, Hour = 1, Day = 2 };
+
+struct AggregateBucket {
+    int64_t start = 0;                 // UNIX 秒 (バケット先頭)
+    std::vector<uint32_t> counts;      // categories と同じ並び
+    uint32_t cycles = 0;               // 監視サイクル数
+    uint32_t errors = 0;
+    double latency_sum = 0.0;          // 秒
+};
+
+struct AggregateReport {
+    std::string use_case;
+    AggregateSpan span = AggregateSpan::Hour;
+    int64_t bucket_sec = 0;
+    std::vector<std::string> categories;   // 末尾は "other" (options 外の回答)
+    std::vector<uint64_t> counts;          // 窓全体の合計
+    uint64_t cycles = 0;
+    uint64_t errors = 0;
+    double mean_latency = 0.0;
+    std::vector<AggregateBucket> buckets;  // 古い順 (空のバケットは含まない)
+};
+
+// =============================================================================
+class RollingAggregates {
+public:
+    RollingAggregates(const std::string& use_case, std::vector<std::string> categories);
+
+    // 1 サイクル分を記録 (モザイクはビュー数分の categories を渡す)
+    void record(std::chrono::system_clock::time_point t,
+                const std::vector<std::string>& categories, double latency_sec, bool error);
+
+    AggregateReport query(AggregateSpan span,
+                          std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+
+private:
+    struct Ring {
+        int64_t width = 0;   // バケット幅 (秒)
+        std::vector<AggregateBucket> slots;
+    };
+
+    size_t category_index(const std::string& c) const;
+
+    std::string m_use_case;
+    std::vector<std::string> m_categories;
+    Ring m_rings[3];
+    mutable std::mutex m_mtx;
+};
+
+// "full 62% (31)  low 30% (15)  empty 8% (4)  | 50 cycles, 1.21s avg"
+std::string format_aggregate_summary(const AggregateReport& r);
+// バケットごとの表 (時刻 + カテゴリ別件数)
+std::string format_aggregate_table(const AggregateReport& r);
+const char* aggregate_span_name(AggregateSpan s);
@@ -20,12 +20,65 @@
 //    6. HailoRT User Guide 準拠:
 //       - カスタム推論に direct API (vlm.generate(params, msgs, frames)) を使用
 //       - Generator 同時存在禁止: カスタム推論前に monitor_gen を破棄し完了後に再作成
+//    7. 熱制御:
+//       - テレメトリスレッドで温度/電力を定期取得 (実機 or シミュレーション)
+//       - 熱予算に近づくほど cooldown を滑らかに延長、推論 duty 上限も適用
+//    8. ソークテスト支援:
+//       - エラー/Generator 再作成回数を stats() で公開
+//       - fault_rate で監視推論に擬似エラーを注入しリカバリー経路を検証
+//    9. 共有エグゼキューター:
+//       - カスタム推論は Worker の FIFO に積み promise の future を返す
+//         (完了待ちで共有プールのスレッドを止めない。期限切れは Worker が完了させる)
+//       - カスタム推論の前処理は呼び出し側スレッドで行い Worker を空ける
+//   10. スレッド配置:
+//       - worker / telemetry / pool のコア固定と nice / SCHED_FIFO を設定可能
+//       - スレッド別 CPU 時間を stats() で公開
+//   11. トレース:
+//       - 待機/前処理/generate/トークン読み取り/分類をスパンとして記録 (--trace)
+//   12. 非同期ログ:
+//       - std::cout/cerr の同期 flush をやめ、logger のキュー投入のみで戻る
+//   13. 分類結果の公開:
+//       - InferenceResult::category に分類のみを格納 (状態遷移でクリップ録画)
+//   14. 複数フレーム推論:
+//       - 前処理済みフレームの履歴を保持し、K 枚を 1 回の generate に渡す
+//   15. モザイク:
+//       - 複数ビューをグリッド状に 1 枚へまとめ、番号付き回答をビュー別に分類
+//   16. 対話セッション:
+//       - 同じ画像への追加質問はコンテキストを保持し、発話のみ追加
+//       - トークン上限を超えたら画像を再送して仕切り直す
+//   17. 質問のバッチ化:
+//       - 複数の質問を 1 回の prefill/生成で回答し、番号で分解
+//   18. 生成パラメーター:
+//       - use case ごとの "generation" 設定 (max_tokens "auto" はトークン化から算出)
+//       - GeneratorParams は起動時に作成してキャッシュ
+//   19. 品質ゲート:
+//       - 暗い / 白飛び / 低コントラスト / ブレたフレームは前処理前に捨てる
+//   20. カスケード:
+//       - use case の "prefilter" (HOG / 背景差分 / ヒストグラム) が陰性と確信したら
+//         VLM を呼ばずに設定の回答を返す。陽性・不確実のみ VLM に回す
+//   21. フレーム選択:
+//       - キャプチャスレッドの背景モデルで前景率/前景領域を毎フレーム算出し、
+//         cooldown 中で最も動きの多いフレームを監視に回す
+//       - 鮮鋭度 / 前景率 / 前回推論からの変化 の合成スコアで最良の 1 枚だけを保持
+//   22. スケジュール:
+//       - 時間帯 / 曜日 / 日付ごとに cooldown と停止を切り替え
+//       - 状態が変わる時刻にだけ再評価し、停止中はその時刻まで待機
+//   23. ローリング集計:
+//       - カテゴリ別件数を 1 分 / 1 時間 / 1 日のリングバケットに積む (固定メモリ)
+//   24. ローカル配信:
+//       - 結果 / 状態遷移 / スケジュール切り替えを Unix ドメインソケットに JSON Lines で配信
+//       - 購読者ごとの上限付きキューとまとめ書きで、遅い購読者がワーカーを止めない
 // =============================================================================
 
 #include "backend.h"
+#include "logger.h"
+#include "mosaic.h"
+#include "prefilter.h"
 #include <iomanip>
 #include <algorithm>
+#include <map>
 #include <cctype>
+#include <random>
 
 // =============================================================================
 static std::string escape_json(const std::string& s) {
@@ -45,21 +98,21 @@ static std::string escape_json(const std::string& s) {
 
 // =============================================================================
 bool Backend::diagnose_device() {
-    std::cout << "[Diag] ===== Hailo Device Diagnostics =====" << std::endl;
+    log_info("Diag") << "===== Hailo Device Diagnostics =====";
     auto sr = hailort::Device::scan();
     if (!sr) {
-        std::cerr << "[Diag] Device::scan() FAILED (" << (int)sr.status() << ")" << std::endl;
+        log_error("Diag").field("status", (int)sr.status()) << "Device::scan() FAILED";
         return false;
     }
     auto& ids = sr.value();
-    if (ids.empty()) { std::cerr << "[Diag] No devices." << std::endl; return false; }
-    for (const auto& id : ids) std::cout << "[Diag] Device: " << id << std::endl;
+    if (ids.empty()) { log_error("Diag") << "No devices."; return false; }
+    for (const auto& id : ids) log_info("Diag") << "Device: " << id;
     auto dev = hailort::Device::create(ids[0]);
     if (!dev) {
-        std::cerr << "[Diag] Cannot open (" << (int)dev.status() << ")" << std::endl;
+        log_error("Diag").field("status", (int)dev.status()) << "Cannot open";
         return false;
     }
-    std::cout << "[Diag] OK: " << dev.value()->get_dev_id() << std::endl;
+    log_info("Diag") << "OK: " << dev.value()->get_dev_id();
     return true;
 }
 
@@ -70,16 +123,90 @@ Backend::Backend(const json& prompts,
                  float temperature,
                  uint32_t seed,
                  int cooldown_ms,
-                 int max_retries)
+                 int max_retries,
+                 const BackendOptions& options)
     : m_prompts(prompts), m_hef_path(hef_path),
       m_max_tokens(max_tokens), m_temperature(temperature),
       m_seed(seed), m_cooldown_ms(cooldown_ms),
-      m_max_retries(max_retries)
+      m_max_retries(max_retries), m_options(options)
 {
     if (m_prompts.contains("use_cases") && !m_prompts["use_cases"].empty())
         m_trigger = m_prompts["use_cases"].begin().key();
-    std::cout << "[Backend] Active use case: \"" << m_trigger << "\"" << std::endl;
+    log_info("Backend") << "Active use case: \"" << m_trigger << "\"";
+
+    // 保持したフレームが履歴より古くなり得るので「古い順」が崩れる
+    if (m_options.multi_frames > 1 && m_options.frame_select != FrameSelect::Latest) {
+        log_warn("Backend") << "--multi-frame requires --frame-select latest - --multi-frame ignored.";
+        m_options.multi_frames = 1;
+    }
+
+    const size_t views = m_options.mosaic_rois.size();
+    if (views > 1) {
+        if (m_options.multi_frames > 1) {
+            log_warn("Backend") << "Mosaic uses a single frame per inference - --multi-frame ignored.";
+            m_options.multi_frames = 1;
+        }
+        auto g = mosaic_grid(views);
+        log_info("Backend") << "Mosaic: " << views << " views (" << g.width << "x" << g.height << " grid)";
+    }
+
+    // シミュレーション時は実機を待たずにテレメトリを開始
+    if (m_options.thermal.simulate)
+        set_telemetry_source(std::make_unique<SimulatedTelemetrySource>());
+    if (m_options.thermal.enabled()) {
+        log_info("Backend") << "Thermal budget: throttle "
+                            << m_options.thermal.throttle_start_c << "C -> "
+                            << m_options.thermal.limit_c << "C (max x"
+                            << m_options.thermal.max_slowdown << ", release below "
+                            << m_options.thermal.throttle_start_c - m_options.thermal.hysteresis_c << "C)";
+    }
+
+    {
+        std::vector<std::string> cats;
+        if (m_prompts.contains("use_cases") && m_prompts["use_cases"].contains(m_trigger) &&
+            m_prompts["use_cases"][m_trigger].contains("options"))
+            for (const auto& o : m_prompts["use_cases"][m_trigger]["options"])
+                cats.push_back(o.get<std::string>());
+        m_aggregates = std::make_unique<RollingAggregates>(m_trigger, std::move(cats));
+    }
+
+    // スケジュール: ストリーム (--schedule) > use case > プロンプト最上位
+    m_schedule = m_options.schedule;
+    if (!m_schedule.enabled()) {
+        const json* node = nullptr;
+        if (m_prompts.contains("use_cases") && m_prompts["use_cases"].contains(m_trigger) &&
+            m_prompts["use_cases"][m_trigger].contains("schedule"))
+            node = &m_prompts["use_cases"][m_trigger]["schedule"];
+        else if (m_prompts.contains("schedule"))
+            node = &m_prompts["schedule"];
+        std::string err;
+        if (node && !m_schedule.parse(*node, err))
+            log_warn("Schedule") << "Ignored: " << err;
+    }
+    if (m_schedule.enabled())
+        log_info("Schedule") << m_schedule.size() << " rule(s); default cooldown "
+                             << m_cooldown_ms << "ms";
+
+    if (m_options.publish.enabled()) {
+        m_publisher = std::make_unique<ResultPublisher>(m_options.publish);
+        if (!m_publisher->start()) m_publisher.reset();
+    }
+
+    if (m_options.frame_select != FrameSelect::Latest) {
+        m_bg_model = std::make_unique<BackgroundModel>(m_options.foreground);
+        if (m_options.frame_select == FrameSelect::Best)
+            log_info("Backend") << "Frame selection: best score per cooldown window (weights sharpness="
+                                << m_options.frame_score.sharpness << " foreground="
+                                << m_options.frame_score.foreground << " change="
+                                << m_options.frame_score.change << ")";
+        else
+            log_info("Backend") << "Frame selection: most foreground activity per cooldown window";
+    }
+
+    m_pool = std::make_unique<ThreadPool>(m_options.pool_threads, m_options.pool_policy);
+    m_request_pool = std::make_unique<ThreadPool>(1, m_options.pool_policy, "requests");
     m_worker = std::thread(&Backend::worker_func, this);
+    m_telemetry = std::thread(&Backend::telemetry_func, this);
 }
 
 Backend::~Backend() { close(); }
@@ -91,9 +218,19 @@ Backend::~Backend() { close(); }
 //  5秒待って応答がなければ detach してアプリは終了する。
 // =============================================================================
 void Backend::close() {
-    if (!m_running.exchange(false)) return;
+    {
+        // enqueue_custom_request と同じロック下で止め、以降の要求を積ませない
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running.exchange(false)) return;
+    }
     m_abort_requested = true;
     m_cv.notify_all();
+    fail_custom_requests({"Backend closed", "N/A"}, false);
+    {
+        std::lock_guard<std::mutex> lk(m_telemetry_mtx);
+        m_telemetry_cv.notify_all();
+    }
+    if (m_telemetry.joinable()) m_telemetry.join();
 
     if (m_worker.joinable()) {
         // タイムアウト付き待機: worker_done フラグを 5秒間ポーリング
@@ -107,18 +244,66 @@ void Backend::close() {
         if (m_worker_done.load()) {
             m_worker.join();
         } else {
-            std::cerr << "[Backend] Worker not responding - detaching thread." << std::endl;
+            log_warn("Backend") << "Worker not responding - detaching thread.";
             m_worker.detach();
         }
     }
+    // 応答しない Worker が抱えている要求も含め、待っている呼び出し側を起こす
+    fail_custom_requests({"Backend closed", "N/A"}, true);
+    if (m_request_pool) m_request_pool->shutdown();
+    if (m_pool) m_pool->shutdown();
+    // worker が止まってから閉じる (detach 時も publish() は m_running を見て戻る)
+    if (m_publisher) m_publisher->close();
 }
 
 // =============================================================================
 void Backend::update_frame(const cv::Mat& frame) {
+    VLM_TRACE_SCOPE("update_frame");
+    // 複数フレーム推論: window / (K-1) 間隔で前処理済みフレームを履歴に積む
+    // (m_history_last_push は呼び出し側スレッドのみが触る。m_frame_h / m_frame_w は
+    //  Worker がモデル読み込み時に書くので、m_device_ready が立つまでは積まない)
+    cv::Mat history_rgb;
+    const int k = m_options.multi_frames;
+    if (k > 1 && m_device_ready.load(std::memory_order_acquire)) {
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::chrono::duration<double>(m_options.multi_frame_window_sec / (k - 1));
+        if (now - m_history_last_push >= interval) {
+            m_history_last_push = now;
+            history_rgb = preprocess_image(frame, m_frame_h, m_frame_w);
+        }
+    }
+    ForegroundStats fg;
+    if (m_bg_model) fg = m_bg_model->update(frame);
+    FrameScore score;
+    if (m_options.frame_select == FrameSelect::Best) {
+        cv::Mat reference;
+        {
+            // thumb は差し替えのみで書き換えないので参照共有で足りる
+            std::lock_guard<std::mutex> lk(m_mtx);
+            reference = m_inferred_thumb;
+        }
+        score = score_frame(frame, fg, reference, m_options.frame_score);
+    }
     {
         std::lock_guard<std::mutex> lk(m_mtx);
-        frame.copyTo(m_pending_frame);
-        m_has_pending = true;
+        // 未取得のフレームより劣るなら置き換えない (同点なら新しい方)
+        bool keep = false;
+        if (m_has_pending) {
+            if (m_options.frame_select == FrameSelect::Foreground)
+                keep = m_pending_fg.valid && fg.ratio < m_pending_fg.ratio;
+            else if (m_options.frame_select == FrameSelect::Best)
+                keep = score.total < m_pending_score.total;
+        }
+        if (!keep) {
+            frame.copyTo(m_pending_frame);
+            m_pending_fg = std::move(fg);
+            m_pending_score = std::move(score);
+            m_has_pending = true;
+        }
+        if (!history_rgb.empty()) {
+            m_frame_history.push_back(std::move(history_rgb));
+            while ((int)m_frame_history.size() > k - 1) m_frame_history.pop_front();
+        }
     }
     m_cv.notify_one();
 }
@@ -128,46 +313,208 @@ bool Backend::poll_result(MonitoringResult& out) {
     if (!m_has_result) return false;
     out.frame   = std::move(m_result_buf.frame);
     out.result  = std::move(m_result_buf.result);
+    out.views   = std::move(m_result_buf.views);
+    out.foreground = std::move(m_result_buf.foreground);
     m_has_result = false;
     return true;
 }
 
+BackendStats Backend::stats() const {
+    BackendStats st;
+    {
+        std::lock_guard<std::mutex> lk(m_telemetry_mtx);
+        st.temperature_c    = m_last_sample.temperature_c;
+        st.power_w          = m_last_sample.power_w;
+        st.telemetry_source = m_telemetry_name;
+        st.duty_cycle       = m_duty_cycle;
+        st.throttle_events  = m_throttle_events;
+        st.throttled_sec    = m_throttled_sec;
+    }
+    st.throttle_factor     = m_throttle_factor.load();
+    st.inferences          = m_inferences.load();
+    st.errors              = m_errors.load();
+    st.generator_recreates = m_generator_recreates.load();
+    st.skipped_dark         = m_quality_skips[(int)QualityVerdict::Dark].load();
+    st.skipped_overexposed  = m_quality_skips[(int)QualityVerdict::Overexposed].load();
+    st.skipped_low_contrast = m_quality_skips[(int)QualityVerdict::LowContrast].load();
+    st.skipped_blurred      = m_quality_skips[(int)QualityVerdict::Blurred].load();
+    st.prefilter_negatives   = m_prefilter_negatives.load();
+    st.prefilter_escalations = m_prefilter_escalations.load();
+    if (m_publisher) {
+        st.published       = m_publisher->published();
+        st.publish_dropped = m_publisher->dropped();
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        st.schedule = m_schedule_status;
+    }
+    st.thread_cpu_sec      = thread_cpu_times();
+    return st;
+}
+
+AggregateReport Backend::aggregates(AggregateSpan span) const {
+    return m_aggregates->query(span);
+}
+
 void Backend::pause_monitoring()  { m_paused = true; }
 void Backend::resume_monitoring() { m_paused = false; m_cv.notify_one(); }
 void Backend::abort_current()     { m_abort_requested = true; }
 
 // =============================================================================
+namespace {
+// カスタム推論 1 件の期限 (Worker 側のキュー待ち + 生成、呼び出し側の待機とも)
+constexpr auto kCustomTimeout = std::chrono::seconds(60);
+
+std::future<InferenceResult> ready_result(InferenceResult r) {
+    std::promise<InferenceResult> p;
+    p.set_value(std::move(r));
+    return p.get_future();
+}
+} // namespace
+
+// Worker が generate / トークン読み取りで固まっても呼び出し側は期限で戻る
+InferenceResult Backend::wait_custom_result(std::future<InferenceResult> fut) {
+    if (fut.wait_for(kCustomTimeout) == std::future_status::timeout) {
+        m_abort_requested = true;
+        return {"VLM timeout", "60 seconds"};
+    }
+    try { return fut.get(); }
+    catch (...) { return {"VLM error", "N/A"}; }
+}
+
 InferenceResult Backend::vlm_custom_inference(const cv::Mat& image,
                                                const std::string& prompt) {
-    if (!m_device_ready) return {"Device not ready", "N/A"};
+    return wait_custom_result(submit_custom_inference(image, prompt));
+}
 
+// 完了待ちは呼び出し側に任せる (タイムアウト / close は Worker と close() が promise を完了させる)
+std::future<InferenceResult> Backend::enqueue_custom_request(cv::Mat rgb, const std::string& prompt,
+                                                             bool session, uint32_t max_tokens) {
     auto prom = std::make_shared<std::promise<InferenceResult>>();
     auto canc = std::make_shared<std::atomic<bool>>(false);
     auto fut  = prom->get_future();
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running || m_worker_done) return ready_result({"Backend closed", "N/A"});
+        m_vlm_reqs.push_back(VLMReq{std::move(rgb), prompt, session, max_tokens,
+                                    std::chrono::steady_clock::now() + kCustomTimeout,
+                                    prom, canc});
+    }
+    m_cv.notify_one();
+    return fut;
+}
 
+void Backend::fail_custom_requests(const InferenceResult& result, bool include_inflight) {
+    std::deque<VLMReq> reqs;
     {
         std::lock_guard<std::mutex> lk(m_mtx);
-        m_vlm_req = VLMReq{image.clone(), prompt, prom, canc};
+        reqs.swap(m_vlm_reqs);
+        if (include_inflight && m_vlm_inflight) reqs.push_back(*m_vlm_inflight);
     }
+    for (auto& r : reqs) {
+        bool exp = false;
+        if (r.cancelled->compare_exchange_strong(exp, true)) {
+            try { r.promise_ptr->set_value(result); }
+            catch (const std::future_error&) {}
+        }
+    }
+}
+
+std::future<InferenceResult> Backend::submit_custom_inference(const cv::Mat& image,
+                                                              const std::string& prompt) {
+    if (!m_device_ready) return ready_result({"Device not ready", "N/A"});
+    // 前処理は呼び出し側スレッドで実行 (Worker はデバイス処理に専念)
+    return enqueue_custom_request(preprocess_image(image, m_frame_h, m_frame_w), prompt, false);
+}
+
+std::future<InferenceResult> Backend::submit_session_question(const cv::Mat& image,
+                                                              const std::string& prompt) {
+    if (!m_device_ready) return ready_result({"Device not ready", "N/A"});
+    // 空の画像 = 追加質問 (前処理なし)
+    cv::Mat rgb = image.empty() ? cv::Mat() : preprocess_image(image, m_frame_h, m_frame_w);
+    return enqueue_custom_request(std::move(rgb), prompt, true);
+}
+
+void Backend::end_session() {
+    m_end_session = true;
     m_cv.notify_one();
+}
 
-    auto st = fut.wait_for(std::chrono::seconds(60));
-    if (st == std::future_status::timeout) {
-        canc->store(true);
-        m_abort_requested = true;
-        return {"VLM timeout", "60 seconds"};
+std::future<std::vector<InferenceResult>> Backend::submit_batch_questions(
+    const cv::Mat& image, const std::vector<std::string>& questions, bool session)
+{
+    const size_t n = questions.size();
+    if (!m_device_ready) {
+        std::promise<std::vector<InferenceResult>> p;
+        p.set_value(std::vector<InferenceResult>(n, InferenceResult{"Device not ready", "N/A"}));
+        return p.get_future();
     }
-    try { return fut.get(); }
-    catch (...) { return {"VLM error", "N/A"}; }
+    // 空の画像 = セッション中の追加質問 (前処理なし)
+    cv::Mat rgb = image.empty() ? cv::Mat() : preprocess_image(image, m_frame_h, m_frame_w);
+    // 回答を見てから追加の要求を出すので、待機は専用スレッドで行う
+    try {
+        return m_request_pool->submit([this, rgb, questions, session, n]() {
+            return run_batch_questions(rgb, questions, session, n);
+        });
+    } catch (const std::exception&) {
+        // close() 後はエグゼキューターが停止している
+        std::promise<std::vector<InferenceResult>> p;
+        p.set_value(std::vector<InferenceResult>(n, InferenceResult{"Backend closed", "N/A"}));
+        return p.get_future();
+    }
+}
+
+std::vector<InferenceResult> Backend::run_batch_questions(
+    const cv::Mat& rgb, const std::vector<std::string>& questions, bool session, size_t n)
+{
+    std::vector<InferenceResult> out(n);
+    if (n == 1) {
+        out[0] = wait_custom_result(enqueue_custom_request(rgb, questions[0], session));
+        return out;
+    }
+
+    std::ostringstream p;
+    p << "Answer each of the following questions about the image. "
+         "Reply with exactly one line per question in the form '<number>: <answer>'.\n";
+    for (size_t i = 0; i < n; i++) p << (i + 1) << ". " << questions[i] << "\n";
+
+    // 1 問あたり 80 トークン (上限 400)
+    auto batch = wait_custom_result(enqueue_custom_request(
+        rgb, p.str(), session, std::min<uint32_t>(400, 80 * (uint32_t)n)));
+    std::vector<std::string> answers;
+    if (!batch.error) answers = parse_numbered_answers(batch.answer, n);
+
+    size_t fallback = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i < answers.size() && !answers[i].empty()) {
+            out[i].answer   = answers[i];
+            out[i].time_str = batch.time_str;
+            out[i].seconds  = batch.seconds;
+            continue;
+        }
+        // 取り出せなかった質問は個別に問い合わせる
+        // (セッション中なら画像を再送しない追加質問になる)
+        fallback++;
+        bool follow_up = session && (rgb.empty() || !batch.error);
+        out[i] = wait_custom_result(follow_up ? enqueue_custom_request(cv::Mat(), questions[i], true)
+                                              : enqueue_custom_request(rgb, questions[i], session));
+    }
+    log_info("Backend") << "Batch: " << n << " questions, " << (n - fallback)
+                        << " answered in one generation, " << fallback << " individually";
+    return out;
 }
 
 // =============================================================================
 cv::Mat Backend::preprocess_image(const cv::Mat& img, int h, int w) {
+    VLM_TRACE_SCOPE("preprocess");
+    // 先にモデル入力サイズへ縮小してから色変換する (全画素の変換パスを省く。
+    // INTER_NEAREST は画素を選ぶだけなので順序を入れ替えても結果は同じ)
+    cv::Mat small = img;
+    if (img.rows != h || img.cols != w)
+        cv::resize(img, small, cv::Size(w, h), 0, 0, cv::INTER_NEAREST);
     cv::Mat r;
-    if (img.channels() == 3) cv::cvtColor(img, r, cv::COLOR_BGR2RGB);
-    else r = img.clone();
-    if (r.rows != h || r.cols != w)
-        cv::resize(r, r, cv::Size(w, h), 0, 0, cv::INTER_NEAREST);
+    if (small.channels() == 3) cv::cvtColor(small, r, cv::COLOR_BGR2RGB);
+    else r = (small.data == img.data) ? img.clone() : small;
     if (r.depth() != CV_8U) r.convertTo(r, CV_8U);
     if (!r.isContinuous()) r = r.clone();
     return r;
@@ -177,7 +524,18 @@ cv::Mat Backend::preprocess_image(const cv::Mat& img, int h, int w) {
 std::vector<std::string> Backend::build_messages(
     const std::string& trigger,
     const std::string& sys,
-    const std::string& usr)
+    const std::string& usr,
+    size_t num_images)
+{
+    return build_prompt_messages(m_prompts, trigger, sys, usr, num_images);
+}
+
+std::vector<std::string> build_prompt_messages(
+    const json& prompts,
+    const std::string& trigger,
+    const std::string& sys,
+    const std::string& usr,
+    size_t num_images)
 {
     std::vector<std::string> msgs;
     if (!sys.empty()) {
@@ -188,23 +546,259 @@ std::vector<std::string> Backend::build_messages(
     }
     std::string prompt = usr;
     if (trigger != "custom" &&
-        m_prompts.contains("use_cases") &&
-        m_prompts["use_cases"].contains(trigger) &&
-        m_prompts["use_cases"][trigger].contains("details"))
+        prompts.contains("use_cases") &&
+        prompts["use_cases"].contains(trigger) &&
+        prompts["use_cases"][trigger].contains("details"))
     {
-        auto d = m_prompts["use_cases"][trigger]["details"].get<std::string>();
+        auto d = prompts["use_cases"][trigger]["details"].get<std::string>();
         auto p = prompt.find("{details}");
         if (p != std::string::npos) prompt.replace(p, 9, d);
     }
     {
         std::ostringstream o;
-        o << R"({"role":"user","content":[{"type":"image"},{"type":"text","text":")"
-          << escape_json(prompt) << R"("}]})";
+        o << R"({"role":"user","content":[)";
+        for (size_t i = 0; i < num_images; i++) o << R"({"type":"image"},)";
+        o << R"({"type":"text","text":")" << escape_json(prompt) << R"("}]})";
         msgs.push_back(o.str());
     }
     return msgs;
 }
 
+// =============================================================================
+//  生成パラメーター
+//    プロンプト JSON の use case ごとの "generation" / 最上位の "custom_generation":
+//    {"max_tokens": 12 | "auto", "temperature": 0.1, "seed": 42, "auto_margin": 4}
+// =============================================================================
+struct GenerationSettings {
+    uint32_t max_tokens;
+    float temperature;
+    uint32_t seed;
+    bool auto_tokens = false;    // options/keywords の最長トークン数 + auto_margin
+    uint32_t auto_margin = 4;
+};
+
+static GenerationSettings parse_generation(const json& node, GenerationSettings g) {
+    if (!node.is_object()) return g;
+    if (node.contains("max_tokens")) {
+        const auto& mt = node["max_tokens"];
+        if (mt.is_string() && mt.get<std::string>() == "auto") g.auto_tokens = true;
+        else if (mt.is_number_integer() && mt.get<int>() > 0) g.max_tokens = mt.get<uint32_t>();
+        else log_warn("Backend") << "Invalid generation.max_tokens: " << mt.dump();
+    }
+    g.temperature = node.value("temperature", g.temperature);
+    g.seed        = node.value("seed", g.seed);
+    g.auto_margin = node.value("auto_margin", g.auto_margin);
+    return g;
+}
+
+// =============================================================================
+std::string Backend::classify_response(const std::string& response) {
+    // レスポンスから分類結果を抽出
+    // 2Bモデルはプロンプトを復唱することがある:
+    //   "pickup if a person is reaching, browsing if..."
+    // 対策: まず短い応答なら全体でマッチ、
+    //       長い応答なら先頭の単語のみでマッチ
+    std::string response_lower = response;
+    std::transform(response_lower.begin(), response_lower.end(),
+                   response_lower.begin(), ::tolower);
+
+    std::string answer = "No Event Detected";
+    if (!m_prompts.contains("use_cases") ||
+        !m_prompts["use_cases"].contains(m_trigger))
+        return answer;
+    auto& uc = m_prompts["use_cases"][m_trigger];
+
+    // ---- キーワードマッチング方式 ----
+    // JSON に "keywords" があれば、モデルの自由回答から
+    // キーワードで分類する (options 順に優先)
+    if (uc.contains("keywords") && uc["keywords"].is_object()) {
+        auto& kw_map = uc["keywords"];
+        for (const auto& opt : uc["options"]) {
+            std::string cat = opt.get<std::string>();
+            if (!kw_map.contains(cat)) continue;
+            for (const auto& kw : kw_map[cat]) {
+                std::string k = kw.get<std::string>();
+                std::transform(k.begin(), k.end(),
+                               k.begin(), ::tolower);
+                if (response_lower.find(k) != std::string::npos) {
+                    return cat;
+                }
+            }
+        }
+        // どのキーワードにもマッチしない場合
+        // → 人に言及していない → 最初のオプション (empty) を使用
+        if (!uc["options"].empty()) {
+            answer = uc["options"][0].get<std::string>();
+        }
+    }
+    // ---- フォールバック: 旧方式 (options 直接マッチ) ----
+    else if (uc.contains("options")) {
+        // 先頭部分を抽出 (復唱対策)
+        std::string first_part = response_lower;
+        for (const char* delim : {"\n", ".", ",", " if ", " or "}) {
+            auto pos = first_part.find(delim);
+            if (pos != std::string::npos && pos > 0)
+                first_part = first_part.substr(0, pos);
+        }
+        auto trim = [](std::string& s) {
+            const char* ws = " \t\n\r'\"";
+            auto l = s.find_first_not_of(ws);
+            auto r = s.find_last_not_of(ws);
+            s = (l != std::string::npos) ? s.substr(l, r - l + 1) : "";
+        };
+        trim(first_part);
+
+        for (const auto& opt : uc["options"]) {
+            std::string o = opt.get<std::string>();
+            std::string o_lower = o;
+            std::transform(o_lower.begin(), o_lower.end(),
+                           o_lower.begin(), ::tolower);
+            if (first_part == o_lower ||
+                first_part.rfind(o_lower, 0) == 0) {
+                answer = o;
+                break;
+            }
+        }
+        // 短い応答なら含有マッチ
+        if (answer == "No Event Detected" &&
+            response_lower.size() < 30)
+        {
+            for (const auto& opt : uc["options"]) {
+                std::string o = opt.get<std::string>();
+                std::string o_lower = o;
+                std::transform(o_lower.begin(), o_lower.end(),
+                               o_lower.begin(), ::tolower);
+                if (response_lower.find(o_lower) != std::string::npos) {
+                    answer = o;
+                    break;
+                }
+            }
+        }
+    }
+    return answer;
+}
+
+static void replace_all(std::string& s, const std::string& key, const std::string& val) {
+    for (size_t p = s.find(key); p != std::string::npos; p = s.find(key, p + val.size()))
+        s.replace(p, key.size(), val);
+}
+
+// 監視用メッセージ
+//   複数フレーム時: 時系列であることをプロンプトで伝える
+//   モザイク時:     グリッド構成と番号付きの回答形式を指示する
+std::vector<std::string> Backend::build_monitor_messages(size_t num_images) {
+    std::string usr = m_prompts.value("hailo_user_prompt", "");
+    const size_t views = m_options.mosaic_rois.size();
+    if (views > 1) {
+        auto g = mosaic_grid(views);
+        std::string tmpl = m_prompts.value("hailo_mosaic_user_prompt", std::string(
+            "The image is a {grid} grid of {views} separate camera views, numbered 1 to {views} "
+            "left to right, top to bottom. For each view: {prompt} "
+            "Answer with one line per view in the form '<number>: <answer>'."));
+        replace_all(tmpl, "{grid}", std::to_string(g.width) + "x" + std::to_string(g.height));
+        replace_all(tmpl, "{views}", std::to_string(views));
+        replace_all(tmpl, "{prompt}", usr);
+        usr = tmpl;
+    } else if (num_images > 1) {
+        std::string tmpl = m_prompts.value("hailo_multi_frame_user_prompt", std::string(
+            "The {frames} images are consecutive frames from the same camera, "
+            "oldest first. {prompt}"));
+        replace_all(tmpl, "{frames}", std::to_string(num_images));
+        replace_all(tmpl, "{prompt}", usr);
+        usr = tmpl;
+    }
+    return build_messages(m_trigger, m_prompts.value("hailo_system_prompt", ""), usr, num_images);
+}
+
+// =============================================================================
+//  テレメトリ / 熱制御
+// =============================================================================
+void Backend::set_telemetry_source(std::unique_ptr<TelemetrySource> src) {
+    // 戻った時点で旧ソースは使われていない (VDevice 解放前の切り離しに使う)
+    std::string name = src ? src->name() : "none";
+    {
+        std::lock_guard<std::mutex> lk(m_telemetry_src_mtx);
+        m_telemetry_src = std::move(src);
+    }
+    std::lock_guard<std::mutex> lk(m_telemetry_mtx);
+    m_telemetry_name = std::move(name);
+}
+
+// 熱倍率と duty 上限を反映した監視推論の cooldown
+//   duty 上限 d: infer / (infer + cooldown) <= d  →  cooldown >= infer * (1-d) / d
+std::chrono::milliseconds Backend::current_cooldown(
+    std::chrono::steady_clock::duration last_infer_time, int base_ms) const
+{
+    double ms = base_ms * m_throttle_factor.load();
+    double d = m_options.thermal.max_duty;
+    if (d > 0.0 && d < 1.0) {
+        double infer_ms = std::chrono::duration<double, std::milli>(last_infer_time).count();
+        ms = std::max(ms, infer_ms * (1.0 - d) / d);
+    }
+    return std::chrono::milliseconds((int64_t)ms);
+}
+
+void Backend::telemetry_func() {
+    ThreadCpuScope cpu("telemetry");
+    apply_thread_policy(m_options.telemetry_policy, "telemetry");
+
+    ThermalGovernor governor(m_options.thermal);
+    const auto interval = std::chrono::milliseconds(
+        std::max(100, m_options.thermal.sample_interval_ms));
+
+    auto last = std::chrono::steady_clock::now();
+    int64_t last_busy = m_busy_ns.load();
+
+    while (m_running) {
+        {
+            std::unique_lock<std::mutex> lk(m_telemetry_mtx);
+            m_telemetry_cv.wait_for(lk, interval, [&] { return !m_running.load(); });
+        }
+        if (!m_running) break;
+
+        auto now = std::chrono::steady_clock::now();
+        double dt = std::chrono::duration<double>(now - last).count();
+        int64_t busy = m_busy_ns.load();
+        double duty = dt > 0.0 ? (double)(busy - last_busy) * 1e-9 / dt : 0.0;
+        duty = std::clamp(duty, 0.0, 1.0);
+        last = now;
+        last_busy = busy;
+
+        // サンプリングは公開値のロック外で行う
+        TelemetrySample s;
+        {
+            std::lock_guard<std::mutex> src_lk(m_telemetry_src_mtx);
+            if (m_telemetry_src) s = m_telemetry_src->read(duty);
+        }
+        if (s.temperature_c) VLM_TRACE_COUNTER("temperature_c", *s.temperature_c);
+        VLM_TRACE_COUNTER("duty_cycle", duty);
+
+        bool was_throttling = governor.throttling();
+        double factor = governor.update(s);
+        m_throttle_factor = factor;
+        VLM_TRACE_COUNTER("throttle_factor", factor);
+        {
+            std::lock_guard<std::mutex> lk(m_telemetry_mtx);
+            m_last_sample = s;
+            m_duty_cycle = duty;
+            if (was_throttling) m_throttled_sec += dt;
+            if (!was_throttling && governor.throttling()) m_throttle_events++;
+        }
+
+        if (!was_throttling && governor.throttling()) {
+            log_info("Backend") << "Thermal throttle ON: "
+                                << std::fixed << std::setprecision(1)
+                                << governor.smoothed_temperature().value_or(0.0)
+                                << "C, cooldown x" << std::setprecision(2) << factor;
+        } else if (was_throttling && !governor.throttling()) {
+            log_info("Backend") << "Thermal throttle OFF: "
+                                << std::fixed << std::setprecision(1)
+                                << governor.smoothed_temperature().value_or(0.0)
+                                << "C";
+        }
+    }
+}
+
 // =============================================================================
 //  トークン読み取り (read タイムアウト 2秒)
 // =============================================================================
@@ -213,21 +807,27 @@ static std::string read_all_tokens(
     uint32_t max_tokens,
     bool stream,
     std::atomic<bool>& abort_flag,
-    const std::shared_ptr<std::atomic<bool>>& cancelled)
+    const std::shared_ptr<std::atomic<bool>>& cancelled,
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
 {
+    VLM_TRACE_SCOPE("read_tokens");
     std::string response;
     uint32_t n = 0;
 
     while (completion.generation_status()
            == hailort::genai::LLMGeneratorCompletion::Status::GENERATING)
     {
-        if (abort_flag.load() || (cancelled && cancelled->load())) {
+        if (abort_flag.load() || (cancelled && cancelled->load()) ||
+            std::chrono::steady_clock::now() >= deadline) {
             try { completion.abort(); } catch (...) {}
             break;
         }
 
     // 2秒タイムアウト (高速 abort 応答)
-        auto tok = completion.read(std::chrono::seconds(2));
+        auto tok = [&] {
+            VLM_TRACE_SCOPE("token_read");
+            return completion.read(std::chrono::seconds(2));
+        }();
         if (!tok) {
             // read 失敗 → abort して脱出
             try { completion.abort(); } catch (...) {}
@@ -239,7 +839,7 @@ static std::string read_all_tokens(
         n++;
 
         if (stream && t != "<|im_end|>")
-            std::cout << t << std::flush;
+            log_raw(t);
 
         if (n >= max_tokens) {
             try { completion.abort(); } catch (...) {}
@@ -264,21 +864,24 @@ static std::string read_all_tokens(
 //  worker_func
 // =============================================================================
 void Backend::worker_func() {
+    ThreadCpuScope cpu("worker");
+    apply_thread_policy(m_options.worker_policy, "worker");
+
     // -------------------------------------------------------
     //  Phase 1: デバイススキャン
     // -------------------------------------------------------
-    std::cout << "[Backend] Scanning devices..." << std::endl;
+    log_info("Backend") << "Scanning devices...";
     {
         auto sr = hailort::Device::scan();
         if (sr) {
             auto& ids = sr.value();
             if (ids.empty()) {
-                std::cerr << "[Backend] No devices found." << std::endl;
+                log_error("Backend") << "No devices found.";
                 m_worker_done = true;
                 return;
             }
             for (const auto& id : ids)
-                std::cout << "[Backend] Device: " << id << std::endl;
+                log_info("Backend") << "Device: " << id;
         }
     }
 
@@ -292,24 +895,26 @@ void Backend::worker_func() {
     for (int i = 1; i <= m_max_retries && m_running; i++) {
         // 毎回接続前に待機 (初回は 3秒、リトライは 5秒)
         int wait_sec = (i == 1) ? 3 : 5;
-        std::cout << "[Backend] Waiting " << wait_sec
-                  << "s before VDevice attempt " << i << "/" << m_max_retries
-                  << "..." << std::endl;
+        log_info("Backend") << "Waiting " << wait_sec
+                            << "s before VDevice attempt " << i << "/" << m_max_retries
+                            << "...";
         for (int s = 0; s < wait_sec && m_running; s++)
             std::this_thread::sleep_for(std::chrono::seconds(1));
         if (!m_running) break;
 
-        std::cout << "[Backend] Creating VDevice (" << i << "/" << m_max_retries << ")..." << std::endl;
+        log_info("Backend") << "Creating VDevice (" << i << "/" << m_max_retries << ")...";
         auto r = hailort::VDevice::create_shared();
         if (r) {
             vdevice = r.release();
-            std::cout << "[Backend] VDevice OK." << std::endl;
+            log_info("Backend") << "VDevice OK.";
+            if (!m_options.thermal.simulate)
+                set_telemetry_source(std::make_unique<HailoTelemetrySource>(vdevice));
             break;
         }
-        std::cerr << "[Backend] Failed (" << (int)r.status() << ")" << std::endl;
+        log_warn("Backend").field("status", (int)r.status()) << "Failed";
     }
     if (!vdevice) {
-        std::cerr << "[Backend] FATAL: Cannot create VDevice." << std::endl;
+        log_error("Backend") << "FATAL: Cannot create VDevice.";
         m_worker_done = true;
         return;
     }
@@ -317,12 +922,13 @@ void Backend::worker_func() {
     // -------------------------------------------------------
     //  Phase 3: VLM ロード
     // -------------------------------------------------------
-    std::cout << "[Backend] Loading VLM: " << m_hef_path << std::endl;
+    log_info("Backend") << "Loading VLM: " << m_hef_path;
     try {
         hailort::genai::VLMParams vlm_params(m_hef_path, true);
         auto vr = hailort::genai::VLM::create(vdevice, vlm_params);
         if (!vr) {
-            std::cerr << "[Backend] VLM::create failed (" << (int)vr.status() << ")" << std::endl;
+            log_error("Backend").field("status", (int)vr.status()) << "VLM::create failed";
+            if (!m_options.thermal.simulate) set_telemetry_source(nullptr);
             m_worker_done = true;
             return;
         }
@@ -333,9 +939,9 @@ void Backend::worker_func() {
         m_frame_w = (int)shape.width;
         uint32_t frame_size = vlm.input_frame_size();
 
-        std::cout << "[Backend] VLM ready. Frame: "
-                  << m_frame_h << "x" << m_frame_w
-                  << " (" << frame_size << " bytes)" << std::endl;
+        log_info("Backend") << "VLM ready. Frame: "
+                            << m_frame_h << "x" << m_frame_w
+                            << " (" << frame_size << " bytes)";
 
         // -------------------------------------------------------
         //  Phase 4: ジェネレーター管理のヘルパー
@@ -343,65 +949,276 @@ void Backend::worker_func() {
         //  監視用ジェネレーターを作成する関数。
         //  エラー時に再作成してリカバリーする。
         // -------------------------------------------------------
+        // モザイク時はビュー数分の回答が必要
+        const auto& mosaic_rois = m_options.mosaic_rois;
+        const bool mosaic = mosaic_rois.size() > 1;
+        const uint32_t views = (uint32_t)std::max<size_t>(1, mosaic_rois.size());
+
+        // ---- 生成パラメーターを use case ごとに作成してキャッシュ ----
+        auto make_params = [&](const GenerationSettings& g, uint32_t max_tokens) {
+            auto p = vlm.create_generator_params()
+                .expect("Failed to create generator params");
+            p.set_temperature(g.temperature);
+            p.set_max_generated_tokens(max_tokens);
+            p.set_seed(g.seed);
+            return p;
+        };
+        // 先頭の空白あり/なしで分割が変わるため多い方を採る
+        auto count_tokens = [&](const std::string& text) -> uint32_t {
+            uint32_t n = 0;
+            for (const auto& t : {text, " " + text}) {
+                auto r = vlm.tokenize(t);
+                if (r) n = std::max(n, (uint32_t)r.value().size());
+            }
+            return n;
+        };
+        auto auto_max_tokens = [&](const json& uc, const GenerationSettings& g) {
+            uint32_t longest = 0;
+            if (uc.contains("options"))
+                for (const auto& o : uc["options"])
+                    longest = std::max(longest, count_tokens(o.get<std::string>()));
+            if (uc.contains("keywords") && uc["keywords"].is_object())
+                for (const auto& [cat, kws] : uc["keywords"].items())
+                    for (const auto& kw : kws)
+                        longest = std::max(longest, count_tokens(kw.get<std::string>()));
+            return longest > 0 ? longest + g.auto_margin : g.max_tokens;
+        };
+
+        struct CachedParams {
+            uint32_t max_tokens;
+            hailort::genai::LLMGeneratorParams params;
+        };
+        const GenerationSettings monitor_defaults{m_max_tokens, m_temperature, m_seed};
+        std::map<std::string, CachedParams> use_case_params;
+        if (m_prompts.contains("use_cases")) {
+            for (const auto& [name, uc] : m_prompts["use_cases"].items()) {
+                auto g = parse_generation(uc.value("generation", json()), monitor_defaults);
+                uint32_t tokens = (g.auto_tokens ? auto_max_tokens(uc, g) : g.max_tokens) * views;
+                use_case_params.emplace(name, CachedParams{tokens, make_params(g, tokens)});
+                log_info("Backend") << "Use case \"" << name << "\": max_tokens=" << tokens
+                                    << (g.auto_tokens ? " (auto)" : "")
+                                    << " temperature=" << g.temperature;
+            }
+        }
+        if (!use_case_params.count(m_trigger))
+            use_case_params.emplace(m_trigger, CachedParams{
+                m_max_tokens * views, make_params(monitor_defaults, m_max_tokens * views)});
+        const CachedParams& monitor_params = use_case_params.at(m_trigger);
+        const uint32_t monitor_max_tokens = monitor_params.max_tokens;
+
+        const GenerationSettings custom_gen = parse_generation(
+            m_prompts.value("custom_generation", json()), GenerationSettings{200, 0.5f, m_seed});
+        const auto custom_params = make_params(custom_gen, custom_gen.max_tokens);
+
         // unique_ptr で管理 (VLMGenerator はコピー/ムーブ代入すべて delete)
         auto create_monitor_generator = [&]()
             -> std::unique_ptr<hailort::genai::VLMGenerator>
         {
-            auto p = vlm.create_generator_params()
-                .expect("Failed to create monitor params");
-            p.set_temperature(m_temperature);
-            p.set_max_generated_tokens(m_max_tokens);
-            p.set_seed(m_seed);
-            auto gen = vlm.create_generator(p)
+            auto gen = vlm.create_generator(monitor_params.params)
                 .expect("Failed to create monitor generator");
             return std::make_unique<hailort::genai::VLMGenerator>(std::move(gen));
         };
 
         auto monitor_gen = create_monitor_generator();
 
-        std::cout << "[Backend] Monitor generator ready." << std::endl;
-        std::cout << "[Backend] Cooldown: " << m_cooldown_ms << "ms" << std::endl;
+        log_info("Backend") << "Monitor generator ready.";
+        log_info("Backend") << "Cooldown: " << m_cooldown_ms << "ms";
 
         // 監視用メッセージをキャッシュ (毎回同じプロンプト)
-        auto cached_monitor_msgs = build_messages(
-            m_trigger,
-            m_prompts.value("hailo_system_prompt", ""),
-            m_prompts.value("hailo_user_prompt", ""));
+        const size_t frames_n = (size_t)std::max(1, m_options.multi_frames);
+        auto cached_monitor_msgs = build_monitor_messages(frames_n);
+        if (frames_n > 1)
+            log_info("Backend") << "Multi-frame mode: " << frames_n << " frames over "
+                                << m_options.multi_frame_window_sec << "s";
 
         m_device_ready = true;
 
         // -------------------------------------------------------
         //  Phase 5: メインループ
         // -------------------------------------------------------
+        // 擬似エラー注入 (fault_rate > 0 のときのみ)
+        std::mt19937 fault_rng(m_seed);
+        std::uniform_real_distribution<double> fault_dist(0.0, 1.0);
+
         auto last_infer = std::chrono::steady_clock::now()
                           - std::chrono::milliseconds(m_cooldown_ms);
-        const auto cooldown = std::chrono::milliseconds(m_cooldown_ms);
+        std::chrono::steady_clock::duration last_infer_time{};
+
+        // 対話セッション (コンテキストに画像と会話が残っている状態)
+        bool session_active = false;
+        cv::Mat session_image;     // 上限超過時の再送用
+        size_t session_turns = 0;
+        const size_t session_budget = m_options.session_token_budget > 0
+            ? m_options.session_token_budget
+            : vlm.max_context_capacity() * 3 / 4;
+
+        // 品質ゲートで連続して落としたフレーム数 (復帰時にログ)
+        uint64_t quality_skip_run = 0;
+        if (m_options.quality.enabled)
+            log_info("Backend") << "Quality gate: luma " << m_options.quality.min_luma << "-"
+                                << m_options.quality.max_luma << ", contrast >= "
+                                << m_options.quality.min_contrast << ", sharpness >= "
+                                << m_options.quality.min_sharpness;
+
+        // ---- カスケード用の前段フィルタ (監視中の use case のみ) ----
+        std::unique_ptr<PreFilter> prefilter;
+        std::string prefilter_answer;
+        int prefilter_verify_every = 0;   // 連続陰性 N 回ごとに 1 回は VLM で確認
+        int prefilter_run = 0;
+        if (m_prompts.contains("use_cases") && m_prompts["use_cases"].contains(m_trigger) &&
+            m_prompts["use_cases"][m_trigger].contains("prefilter"))
+        {
+            const auto& pf = m_prompts["use_cases"][m_trigger]["prefilter"];
+            std::string err;
+            if (mosaic) {
+                log_warn("Backend") << "Prefilter is not supported with --mosaic - disabled.";
+            } else if (!pf.is_object() || !pf.contains("answer")) {
+                log_warn("Backend") << "Prefilter needs an \"answer\" - disabled.";
+            } else if (!(prefilter = create_prefilter(pf, err))) {
+                log_warn("Backend") << "Prefilter disabled: " << err;
+            } else {
+                prefilter_answer = pf["answer"].get<std::string>();
+                prefilter_verify_every = pf.value("verify_every", 10);
+                log_info("Backend") << "Prefilter: " << prefilter->name() << " (negative -> \""
+                                    << prefilter_answer << "\", verify every "
+                                    << prefilter_verify_every << ")";
+            }
+        }
+
+        auto close_session = [&](bool recreate_monitor) {
+            if (!session_active) return;
+            try { vlm.clear_context(); } catch (...) {}
+            session_active = false;
+            session_image.release();
+            log_info("Session") << "Ended after " << session_turns << " turn(s).";
+            session_turns = 0;
+            // 監視用 Generator はセッション中は作らない (終了時に作成)
+            if (recreate_monitor && !monitor_gen) {
+                try { monitor_gen = create_monitor_generator(); }
+                catch (const std::exception& e) {
+                    log_warn("Backend") << "Monitor generator recreate failed: " << e.what();
+                }
+            }
+        };
+
+        // ---- ローカル配信 (結果 + 分類の状態遷移) ----
+        std::string pub_last_category;
+        std::vector<std::string> pub_last_views;
+        auto publish = [&](json j) {
+            j["ts"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            j["use_case"] = m_trigger;
+            // モデル出力に不正な UTF-8 が混ざっても落とさない
+            m_publisher->publish(j.dump(-1, ' ', false, json::error_handler_t::replace));
+        };
+        auto publish_result = [&](const InferenceResult& r, const std::vector<InferenceResult>& views,
+                                  const char* source) {
+            if (!m_publisher) return;
+            json j = {{"type", "result"}, {"source", source}, {"category", r.category},
+                      {"answer", r.answer}, {"latency", r.seconds}, {"error", r.error}};
+            if (!views.empty()) {
+                j["views"] = json::array();
+                for (const auto& v : views) j["views"].push_back(v.category);
+            }
+            publish(std::move(j));
+            if (r.error) return;
+            if (views.empty()) {
+                if (!pub_last_category.empty() && r.category != pub_last_category)
+                    publish({{"type", "state"}, {"from", pub_last_category}, {"to", r.category}});
+                pub_last_category = r.category;
+                return;
+            }
+            pub_last_views.resize(views.size());
+            for (size_t i = 0; i < views.size(); i++) {
+                const auto& cat = views[i].category;
+                if (cat == "unknown") continue;
+                if (!pub_last_views[i].empty() && cat != pub_last_views[i])
+                    publish({{"type", "state"}, {"view", i + 1}, {"from", pub_last_views[i]}, {"to", cat}});
+                pub_last_views[i] = cat;
+            }
+        };
+
+        // スケジュールの現在状態 (next_change を過ぎたときだけ再評価)
+        ScheduleState sched;
+        bool sched_first = true;
 
         while (m_running) {
+            if (m_schedule.enabled() && std::chrono::system_clock::now() >= sched.next_change) {
+                ScheduleState prev = sched;
+                sched = m_schedule.evaluate(std::chrono::system_clock::now());
+                m_schedule_paused = !sched.active;
+                if (sched_first || prev.active != sched.active ||
+                    prev.cooldown_ms != sched.cooldown_ms || prev.label != sched.label)
+                {
+                    std::ostringstream o;
+                    o << (sched.label.empty() ? "default" : sched.label);
+                    if (!sched.active) o << " (paused)";
+                    else o << " (cooldown "
+                           << (sched.cooldown_ms >= 0 ? sched.cooldown_ms : m_cooldown_ms) << "ms)";
+                    o << " until " << format_schedule_time(sched.next_change);
+                    log_info("Schedule") << o.str();
+                    if (m_publisher)
+                        publish({{"type", "schedule"}, {"label", sched.label}, {"active", sched.active},
+                                 {"cooldown_ms", sched.cooldown_ms >= 0 ? sched.cooldown_ms : m_cooldown_ms},
+                                 {"until", std::chrono::duration_cast<std::chrono::seconds>(
+                                      sched.next_change.time_since_epoch()).count()}});
+                    std::lock_guard<std::mutex> lk(m_mtx);
+                    m_schedule_status = o.str();
+                }
+                sched_first = false;
+            }
+            const int base_cooldown_ms = sched.cooldown_ms >= 0 ? sched.cooldown_ms : m_cooldown_ms;
+
             std::optional<VLMReq> vlm_req;
             cv::Mat mon_frame;
+            ForegroundStats mon_fg;
+            std::vector<cv::Mat> mon_history;   // 複数フレーム推論の過去フレーム
             bool have_mon = false;
+            // 熱倍率は待機のたびに再評価 (最大 200ms で追従)
+            const auto cooldown = current_cooldown(last_infer_time, base_cooldown_ms);
+            // スケジュール停止中は次の切り替え時刻まで眠る (カスタム推論 / 終了は notify で起きる)
+            auto wait = std::chrono::milliseconds(200);
+            if (!sched.active)
+                wait = std::clamp(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      sched.next_change - std::chrono::system_clock::now()),
+                                  std::chrono::milliseconds(200), std::chrono::milliseconds(60000));
 
             {
+                VLM_TRACE_SCOPE("worker_wait");
                 std::unique_lock<std::mutex> lk(m_mtx);
-                m_cv.wait_for(lk, std::chrono::milliseconds(200), [&] {
+                m_cv.wait_for(lk, wait, [&] {
                     if (!m_running) return true;
-                    if (m_vlm_req.has_value()) return true;
-                    if (m_has_pending && !m_paused.load()) {
+                    if (!m_vlm_reqs.empty()) return true;
+                    if (m_end_session && session_active) return true;
+                    if (m_has_pending && !m_paused.load() && sched.active) {
                         return (std::chrono::steady_clock::now() - last_infer) >= cooldown;
                     }
                     return false;
                 });
 
                 if (!m_running) break;
+                if (m_end_session.exchange(false)) {
+                    lk.unlock();
+                    close_session(true);
+                    lk.lock();
+                }
 
-                if (m_vlm_req.has_value()) {
-                    vlm_req = std::move(m_vlm_req);
-                    m_vlm_req.reset();
-                } else if (m_has_pending && !m_paused.load()) {
+                if (!m_vlm_reqs.empty()) {
+                    vlm_req = std::move(m_vlm_reqs.front());
+                    m_vlm_reqs.pop_front();
+                    m_vlm_inflight = vlm_req;
+                    m_vlm_inflight->image.release();
+                } else if (m_has_pending && !m_paused.load() && sched.active) {
                     if ((std::chrono::steady_clock::now() - last_infer) >= cooldown) {
                         cv::swap(mon_frame, m_pending_frame);
+                        mon_fg = std::move(m_pending_fg);
+                        m_pending_fg = ForegroundStats();
+                        if (!m_pending_score.thumb.empty())
+                            m_inferred_thumb = std::move(m_pending_score.thumb);
+                        m_pending_score = FrameScore();
                         m_has_pending = false;
+                        // 履歴の Mat は積んだ後に変更しないので参照共有で足りる
+                        mon_history.assign(m_frame_history.begin(), m_frame_history.end());
                         have_mon = true;
                     }
                 }
@@ -413,7 +1230,29 @@ void Backend::worker_func() {
             if (vlm_req.has_value()) {
                 auto& req = vlm_req.value();
                 m_abort_requested = false;
-                if (req.cancelled && req.cancelled->load()) continue;
+                // 完了した要求を実行中から外し、呼び出し側に結果を渡す
+                auto finish = [&](InferenceResult r) {
+                    {
+                        std::lock_guard<std::mutex> lk(m_mtx);
+                        m_vlm_inflight.reset();
+                    }
+                    bool exp = false;
+                    if (req.cancelled->compare_exchange_strong(exp, true)) {
+                        try { req.promise_ptr->set_value(std::move(r)); }
+                        catch (const std::future_error&) {}
+                    }
+                };
+                if (req.cancelled->load()) { finish({}); continue; }
+                // キューで待つ間に期限切れ (デバイスには送らない)
+                if (std::chrono::steady_clock::now() >= req.deadline) {
+                    finish({"VLM timeout", "60 seconds"});
+                    continue;
+                }
+
+                // 追加質問 = セッション要求かつ画像なし
+                // それ以外 (単発 / 新しい画像) は既存のセッションを閉じてから
+                const bool follow_up = req.session && req.image.empty();
+                if (!follow_up) close_session(false);
 
                 // ガイド準拠: Generator は同時に1つのみ存在可能
                 // カスタム推論前に監視用 Generator を破棄する
@@ -423,58 +1262,102 @@ void Backend::worker_func() {
                 auto t0 = std::chrono::steady_clock::now();
 
                 try {
-                    auto rgb = preprocess_image(req.image, m_frame_h, m_frame_w);
-                    hailort::MemoryView fv(rgb.data, frame_size);
+                    // バッチ等で上限が違う場合あり (0 = custom_generation の設定)
+                    const uint32_t max_tokens = req.max_tokens ? req.max_tokens
+                                                               : custom_gen.max_tokens;
+                    cv::Mat image = req.image;
+                    bool send_image = !follow_up;
+                    if (follow_up) {
+                        if (!session_active) throw std::runtime_error("No active session");
+                        // 今回の回答が入りきらなければ画像を再送して仕切り直す
+                        // (回答の上限 + 質問文とチャットテンプレートの概算)
+                        const size_t reserve = max_tokens + 64 + req.prompt.size() / 3;
+                        auto used = vlm.get_context_usage_size();
+                        if (used && used.value() + reserve > session_budget) {
+                            log_info("Session") << "Context " << used.value() << "/" << session_budget
+                                                << " tokens, " << reserve
+                                                << " needed - restarting with the image";
+                            vlm.clear_context();
+                            send_image = true;
+                        }
+                        image = session_image;
+                    }
+                    std::vector<hailort::MemoryView> frames;
+                    if (send_image) frames.emplace_back(image.data, frame_size);
 
                     auto msgs = build_messages(
                         "custom",
-                        "You are a helpful assistant that analyzes images and answers questions about them.",
-                        req.prompt);
+                        send_image ? "You are a helpful assistant that analyzes images and answers questions about them."
+                                   : "",
+                        req.prompt, frames.size());
 
-                    auto cp = vlm.create_generator_params()
-                        .expect("Failed to create custom params");
-                    cp.set_temperature(0.5f);
-                    cp.set_max_generated_tokens(200);
-                    cp.set_seed(m_seed);
+                    // キャッシュ済みのパラメーター (上限が違う場合のみ変更)
+                    auto cp = custom_params;
+                    if (max_tokens != custom_gen.max_tokens) cp.set_max_generated_tokens(max_tokens);
 
                     // ガイド準拠: 一回限りの推論には direct API を使用
-                    auto completion = vlm.generate(cp, msgs, {fv})
-                        .expect("Failed to generate (custom)");
+                    auto completion = [&] {
+                        VLM_TRACE_SCOPE("generate");
+                        return vlm.generate(cp, msgs, frames)
+                            .expect("Failed to generate (custom)");
+                    }();
 
                     result.answer = read_all_tokens(
-                        completion, 200, true,
-                        m_abort_requested, req.cancelled);
-
-                    vlm.clear_context();
+                        completion, max_tokens, true,
+                        m_abort_requested, req.cancelled, req.deadline);
+                    // 期限切れの回答はセッションに残さない
+                    if (std::chrono::steady_clock::now() >= req.deadline) m_abort_requested = true;
+
+                    if (req.session && !m_abort_requested) {
+                        // 画像と会話をコンテキストに残す
+                        session_active = true;
+                        session_image = image;
+                        session_turns++;
+                        auto used = vlm.get_context_usage_size();
+                        if (used)
+                            log_debug("Session").field("turn", session_turns)
+                                                .field("context", used.value()) << "Turn done";
+                    } else {
+                        vlm.clear_context();
+                        session_active = false;
+                    }
                     if (result.answer.empty())
                         result.answer = m_abort_requested ? "Aborted" : "No response";
 
                 } catch (const std::exception& e) {
                     result.answer = std::string("Error: ") + e.what();
+                    result.error = true;
                     try { vlm.clear_context(); } catch (...) {}
+                    session_active = false;
+                    session_image.release();
+                    session_turns = 0;
                 }
 
                 // カスタム推論完了後、監視用 Generator を再作成
-                try {
-                    monitor_gen = create_monitor_generator();
-                } catch (const std::exception& e) {
-                    std::cerr << "[Backend] Monitor generator recreate failed: "
-                              << e.what() << std::endl;
+                // (セッション中はコンテキストを保つため終了時まで作らない)
+                if (!session_active) {
+                    try {
+                        monitor_gen = create_monitor_generator();
+                    } catch (const std::exception& e) {
+                        log_warn("Backend") << "Monitor generator recreate failed: "
+                                            << e.what();
+                    }
                 }
 
                 auto t1 = std::chrono::steady_clock::now();
+                m_busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+                m_inferences++;
+                last_infer_time = t1 - t0;
                 double sec = std::chrono::duration<double>(t1 - t0).count();
                 std::ostringstream ts;
                 ts << std::fixed << std::setprecision(2) << sec << "s";
                 result.time_str = ts.str();
+                result.seconds = sec;
+                VLM_TRACE_COUNTER("latency_ms", sec * 1000.0);
 
-                if (req.promise_ptr && req.cancelled) {
-                    bool exp = false;
-                    if (req.cancelled->compare_exchange_strong(exp, true)) {
-                        try { req.promise_ptr->set_value(std::move(result)); }
-                        catch (const std::future_error&) {}
-                    }
-                }
+                if (std::chrono::steady_clock::now() >= req.deadline && !result.error)
+                    result = {"VLM timeout", "60 seconds"};
+                finish(std::move(result));
                 last_infer = std::chrono::steady_clock::now();
                 continue;
             }
@@ -482,121 +1365,142 @@ void Backend::worker_func() {
             // =========================================================
             //  監視推論
             // =========================================================
+            // 品質ゲート: 前処理の前に縮小フレームで判定し、使えないフレームは捨てる
+            // (last_infer は更新しないので次のフレームをすぐ判定する)
+            if (have_mon && m_options.quality.enabled) {
+                auto q = measure_frame_quality(mon_frame, m_options.quality.analysis_width);
+                auto verdict = judge_frame_quality(q, m_options.quality);
+                if (verdict != QualityVerdict::Ok) {
+                    m_quality_skips[(int)verdict]++;
+                    if (quality_skip_run++ == 0)
+                        log_info("Backend") << "Skipping frames: " << quality_verdict_name(verdict)
+                                            << std::fixed << std::setprecision(1)
+                                            << " (luma=" << q.luma << " contrast=" << q.contrast
+                                            << " sharpness=" << q.sharpness << ")";
+                    VLM_TRACE_COUNTER("quality_skips", (double)quality_skip_run);
+                    continue;
+                }
+                if (quality_skip_run > 0) {
+                    log_info("Backend") << "Frame quality OK after " << quality_skip_run
+                                        << " skipped frame(s).";
+                    quality_skip_run = 0;
+                }
+            }
+
+            // カスケード: 陰性と確信したフレームは VLM を呼ばずに結果を返す
+            // (cooldown は VLM 推論と同じく適用する)
+            if (have_mon && prefilter) {
+                close_session(true);
+                auto t0 = std::chrono::steady_clock::now();
+                auto pr = prefilter->evaluate(mon_frame, mon_fg.valid ? &mon_fg : nullptr);
+                const bool verify = prefilter_verify_every > 0 &&
+                                    prefilter_run >= prefilter_verify_every;
+                if (pr.decision == PreFilterDecision::Negative && !verify) {
+                    prefilter_run++;
+                    m_prefilter_negatives++;
+                    double sec = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - t0).count();
+                    InferenceResult result;
+                    std::ostringstream a, ts;
+                    a << prefilter_answer << " [prefilter: " << prefilter->name() << " "
+                      << std::fixed << std::setprecision(3) << pr.score << "]";
+                    ts << std::fixed << std::setprecision(2) << sec << "s";
+                    result.answer = a.str();
+                    result.category = prefilter_answer;
+                    result.time_str = ts.str();
+                    result.seconds = sec;
+                    m_aggregates->record(std::chrono::system_clock::now(), {prefilter_answer}, sec, false);
+                    publish_result(result, {}, "prefilter");
+                    {
+                        std::lock_guard<std::mutex> lk(m_mtx);
+                        m_result_buf.frame  = std::move(mon_frame);
+                        m_result_buf.result = std::move(result);
+                        m_result_buf.views.clear();
+                        m_result_buf.foreground = std::move(mon_fg);
+                        m_has_result = true;
+                    }
+                    last_infer = std::chrono::steady_clock::now();
+                    continue;
+                }
+                log_debug("Backend") << "Prefilter " << prefilter_decision_name(pr.decision)
+                                     << (verify ? " (verify)" : "") << " score=" << pr.score
+                                     << " -> VLM";
+                prefilter_run = 0;
+                m_prefilter_escalations++;
+            }
+
             if (have_mon) {
                 m_abort_requested = false;
+                close_session(true);   // end_session() なしで監視が再開された場合
 
                 // monitor_gen が未作成の場合 (前回の再作成失敗時)
                 if (!monitor_gen) {
                     try {
+                        m_generator_recreates++;
                         monitor_gen = create_monitor_generator();
                     } catch (const std::exception& e) {
-                        std::cerr << "[Backend] Cannot create monitor generator: "
-                                  << e.what() << std::endl;
+                        log_warn("Backend") << "Cannot create monitor generator: "
+                                            << e.what();
                         continue;
                     }
                 }
 
                 InferenceResult result;
+                std::vector<InferenceResult> view_results;
+                bool injected = false;
                 auto t0 = std::chrono::steady_clock::now();
 
                 try {
+                    // モザイク: ROI をモデル入力サイズのグリッドに配置 (表示にも使う)
+                    if (mosaic) mon_frame = compose_mosaic(mon_frame, mosaic_rois, m_frame_w, m_frame_h);
                     auto rgb = preprocess_image(mon_frame, m_frame_h, m_frame_w);
-                    hailort::MemoryView fv(rgb.data, frame_size);
+                    // 過去フレーム (古い順) + 現在フレーム
+                    std::vector<hailort::MemoryView> frames;
+                    for (const auto& h : mon_history)
+                        if (h.rows == m_frame_h && h.cols == m_frame_w)
+                            frames.emplace_back(h.data, frame_size);
+                    frames.emplace_back(rgb.data, frame_size);
+                    // 履歴が揃うまでは枚数に合わせたメッセージを都度作る
+                    std::vector<std::string> partial_msgs;
+                    if (frames.size() != frames_n) partial_msgs = build_monitor_messages(frames.size());
+                    const auto& msgs = partial_msgs.empty() ? cached_monitor_msgs : partial_msgs;
+
+                    if (m_options.fault_rate > 0.0 &&
+                        fault_dist(fault_rng) < m_options.fault_rate) {
+                        injected = true;
+                        throw std::runtime_error("Injected fault");
+                    }
 
-                    auto completion = monitor_gen->generate(cached_monitor_msgs, {fv})
-                        .expect("Failed to generate (monitor)");
+                    auto completion = [&] {
+                        VLM_TRACE_SCOPE("generate");
+                        return monitor_gen->generate(msgs, frames)
+                            .expect("Failed to generate (monitor)");
+                    }();
 
                     std::string response = read_all_tokens(
-                        completion, m_max_tokens, false,
+                        completion, monitor_max_tokens, false,
                         m_abort_requested, nullptr);
 
                     vlm.clear_context();
 
-                    // レスポンスから分類結果を抽出
-                    // 2Bモデルはプロンプトを復唱することがある:
-                    //   "pickup if a person is reaching, browsing if..."
-                    // 対策: まず短い応答なら全体でマッチ、
-                    //       長い応答なら先頭の単語のみでマッチ
-                    std::string response_lower = response;
-                    std::transform(response_lower.begin(), response_lower.end(),
-                                   response_lower.begin(), ::tolower);
-
-                    result.answer = "No Event Detected";
-                    if (m_prompts.contains("use_cases") &&
-                        m_prompts["use_cases"].contains(m_trigger))
-                    {
-                    auto& uc = m_prompts["use_cases"][m_trigger];
-
-                    // ---- キーワードマッチング方式 ----
-                    // JSON に "keywords" があれば、モデルの自由回答から
-                    // キーワードで分類する (options 順に優先)
-                    if (uc.contains("keywords") && uc["keywords"].is_object()) {
-                        auto& kw_map = uc["keywords"];
-                        for (const auto& opt : uc["options"]) {
-                            std::string cat = opt.get<std::string>();
-                            if (!kw_map.contains(cat)) continue;
-                            for (const auto& kw : kw_map[cat]) {
-                                std::string k = kw.get<std::string>();
-                                std::transform(k.begin(), k.end(),
-                                               k.begin(), ::tolower);
-                                if (response_lower.find(k) != std::string::npos) {
-                                    result.answer = cat;
-                                    goto matched;
-                                }
-                            }
-                        }
-                        // どのキーワードにもマッチしない場合
-                        // → 人に言及していない → 最初のオプション (empty) を使用
-                        if (!uc["options"].empty()) {
-                            result.answer = uc["options"][0].get<std::string>();
+                    if (mosaic) {
+                        // ビュー別に分類し、"1:empty 2:pickup" の形にまとめる
+                        VLM_TRACE_SCOPE("classify");
+                        auto answers = parse_numbered_answers(response, mosaic_rois.size());
+                        std::ostringstream summary;
+                        for (size_t i = 0; i < answers.size(); i++) {
+                            InferenceResult v;
+                            v.answer = answers[i].empty() ? "unknown" : classify_response(answers[i]);
+                            v.category = v.answer;
+                            summary << (i ? " " : "") << (i + 1) << ":" << v.category;
+                            view_results.push_back(std::move(v));
                         }
+                        result.answer = summary.str();
+                    } else {
+                        VLM_TRACE_SCOPE("classify");
+                        result.answer = classify_response(response);
                     }
-                    // ---- フォールバック: 旧方式 (options 直接マッチ) ----
-                    else if (uc.contains("options")) {
-                        // 先頭部分を抽出 (復唱対策)
-                        std::string first_part = response_lower;
-                        for (const char* delim : {"\n", ".", ",", " if ", " or "}) {
-                            auto pos = first_part.find(delim);
-                            if (pos != std::string::npos && pos > 0)
-                                first_part = first_part.substr(0, pos);
-                        }
-                        auto trim = [](std::string& s) {
-                            const char* ws = " \t\n\r'\"";
-                            auto l = s.find_first_not_of(ws);
-                            auto r = s.find_last_not_of(ws);
-                            s = (l != std::string::npos) ? s.substr(l, r - l + 1) : "";
-                        };
-                        trim(first_part);
-
-                        for (const auto& opt : uc["options"]) {
-                            std::string o = opt.get<std::string>();
-                            std::string o_lower = o;
-                            std::transform(o_lower.begin(), o_lower.end(),
-                                           o_lower.begin(), ::tolower);
-                            if (first_part == o_lower ||
-                                first_part.rfind(o_lower, 0) == 0) {
-                                result.answer = o;
-                                break;
-                            }
-                        }
-                        // 短い応答なら含有マッチ
-                        if (result.answer == "No Event Detected" &&
-                            response_lower.size() < 30)
-                        {
-                            for (const auto& opt : uc["options"]) {
-                                std::string o = opt.get<std::string>();
-                                std::string o_lower = o;
-                                std::transform(o_lower.begin(), o_lower.end(),
-                                               o_lower.begin(), ::tolower);
-                                if (response_lower.find(o_lower) != std::string::npos) {
-                                    result.answer = o;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                    } // use_cases guard
-                    matched:
+                    result.category = result.answer;
 
                     // デバッグ: 生レスポンスを表示
                     if (!response.empty()) {
@@ -607,30 +1511,48 @@ void Backend::worker_func() {
 
                 } catch (const std::exception& e) {
                     result.answer = std::string("Error: ") + e.what();
+                    result.error = true;
+                    result.injected = injected;
+                    m_errors++;
                     try { vlm.clear_context(); } catch (...) {}
 
                     // エラー時: ジェネレーター再作成を試行
-                    std::cerr << "\n[Backend] Monitor error, recreating generator..."
-                              << std::endl;
+                    log_warn("Backend") << "Monitor error, recreating generator...";
                     try {
+                        m_generator_recreates++;
                         monitor_gen.reset();
                         monitor_gen = create_monitor_generator();
-                        std::cout << "[Backend] Generator recreated OK." << std::endl;
+                        log_info("Backend") << "Generator recreated OK.";
                     } catch (const std::exception& e2) {
-                        std::cerr << "[Backend] Recreate failed: " << e2.what() << std::endl;
+                        log_warn("Backend") << "Recreate failed: " << e2.what();
                     }
                 }
 
                 auto t1 = std::chrono::steady_clock::now();
+                m_busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+                m_inferences++;
+                last_infer_time = t1 - t0;
                 double sec = std::chrono::duration<double>(t1 - t0).count();
                 std::ostringstream ts;
                 ts << std::fixed << std::setprecision(2) << sec << "s";
                 result.time_str = ts.str();
+                result.seconds = sec;
+                VLM_TRACE_COUNTER("latency_ms", sec * 1000.0);
+                for (auto& v : view_results) { v.time_str = result.time_str; v.seconds = sec; }
+                {
+                    std::vector<std::string> cats;
+                    for (const auto& v : view_results) cats.push_back(v.category);
+                    if (cats.empty()) cats.push_back(result.category);
+                    m_aggregates->record(std::chrono::system_clock::now(), cats, sec, result.error);
+                }
+                publish_result(result, view_results, "vlm");
 
                 {
                     std::lock_guard<std::mutex> lk(m_mtx);
                     m_result_buf.frame  = std::move(mon_frame);
                     m_result_buf.result = std::move(result);
+                    m_result_buf.views  = std::move(view_results);
+                    m_result_buf.foreground = std::move(mon_fg);
                     m_has_result = true;
                 }
                 last_infer = std::chrono::steady_clock::now();
@@ -638,10 +1560,16 @@ void Backend::worker_func() {
         }
 
     } catch (const std::exception& e) {
-        std::cerr << "[Backend] Fatal: " << e.what() << std::endl;
+        log_error("Backend") << "Fatal: " << e.what();
     }
 
+    // VDevice 解放前に実機テレメトリを切り離す
+    if (!m_options.thermal.simulate) set_telemetry_source(nullptr);
     m_device_ready = false;
-    m_worker_done = true;
-    std::cout << "[Backend] Worker exiting." << std::endl;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_worker_done = true;   // 以降の要求は積まずに "Backend closed" を返す
+    }
+    fail_custom_requests({"Backend closed", "N/A"}, true);
+    log_info("Backend") << "Worker exiting.";
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <chrono>
 #include <atomic>
 #include <optional>
+#include <deque>
 #include <iostream>
 #include <sstream>
 #include <future>
@@ -47,17 +48,102 @@
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
+#include "aggregates.h"
+#include "background_model.h"
+#include "frame_quality.h"
+#include "frame_score.h"
+#include "publisher.h"
+#include "schedule.h"
+#include "telemetry.h"
+#include "thread_pool.h"
+#include "trace.h"
+
 // =============================================================================
 struct InferenceResult {
     std::string answer;
     std::string time_str;
+    double seconds = 0.0;
+    bool error = false;
+    bool injected = false;       // fault_rate による擬似エラー (ソークのエラー率から除く)
+    std::string category{};      // 監視時の分類結果 ([raw: ...] を含まない)
 };
 
 struct MonitoringResult {
     cv::Mat frame;
     InferenceResult result;
+    std::vector<InferenceResult> views;   // モザイク時のビュー別結果 (番号順)
+    ForegroundStats foreground;           // 推論したフレームの前景 (背景モデル有効時)
+};
+
+// 監視に回すフレームの選び方
+enum class FrameSelect {
+    Latest,       // cooldown 明けの直前のフレーム (従来動作)
+    Foreground,   // cooldown 中で前景率が最大のフレーム
+    Best,         // 鮮鋭度 + 前景率 + 前回推論からの変化 の合成スコアが最大のフレーム
+};
+
+// 追加オプション (コンストラクタ引数の拡張)
+struct BackendOptions {
+    ThermalConfig thermal;
+    double fault_rate = 0.0;   // 監視推論で擬似エラーを注入する確率 (ソークテスト用)
+    size_t pool_threads = 2;   // 共有エグゼキューターのスレッド数
+    ThreadPolicy pool_policy;
+    ThreadPolicy worker_policy;
+    ThreadPolicy telemetry_policy;
+    // 複数フレーム推論: 直近 multi_frame_window_sec 秒から multi_frames 枚を 1 回の generate に渡す
+    int multi_frames = 1;       // 1 = 単一フレーム (従来動作)
+    double multi_frame_window_sec = 2.0;
+    // モザイク: 2 つ以上の ROI (正規化座標) をグリッドに並べて 1 回で推論
+    std::vector<cv::Rect2d> mosaic_rois;
+    // 対話セッションのコンテキスト上限 (トークン, 0 = 容量の 3/4)
+    size_t session_token_budget = 0;
+    // 品質ゲート: 暗い / 白飛び / 低コントラスト / ブレたフレームは推論しない
+    QualityConfig quality;
+    // 監視フレームの選択 (Latest 以外はキャプチャスレッドで背景モデルを維持)
+    FrameSelect frame_select = FrameSelect::Latest;
+    ForegroundConfig foreground;
+    FrameScoreWeights frame_score;   // FrameSelect::Best の重み
+    // 監視スケジュール (--schedule = このストリーム用。空なら use case /
+    // プロンプト最上位の "schedule" を使う)
+    MonitorSchedule schedule;
+    // 結果 / 状態遷移のローカル配信 (path が空なら無効)
+    PublisherConfig publish;
+};
+
+// stats() のスナップショット
+struct BackendStats {
+    std::optional<float> temperature_c;   // 平滑化前の最新値
+    std::optional<float> power_w;
+    std::string telemetry_source;
+    double duty_cycle = 0.0;              // 直近のサンプリング区間
+    double throttle_factor = 1.0;         // cooldown 倍率
+    uint64_t throttle_events = 0;         // 非減速 → 減速 への遷移回数
+    double throttled_sec = 0.0;           // 減速状態の累計時間
+    uint64_t inferences = 0;
+    uint64_t errors = 0;                  // 監視推論のエラー回数
+    uint64_t generator_recreates = 0;     // エラーリカバリーでの再作成回数
+    // 品質ゲートで推論しなかったフレーム数
+    uint64_t skipped_dark = 0;
+    uint64_t skipped_overexposed = 0;
+    uint64_t skipped_low_contrast = 0;
+    uint64_t skipped_blurred = 0;
+    // カスケード: 前段フィルタで確定した数 / VLM に回した数
+    uint64_t prefilter_negatives = 0;
+    uint64_t prefilter_escalations = 0;
+    uint64_t published = 0;               // 配信したメッセージ数 / 購読者キューで捨てた数
+    uint64_t publish_dropped = 0;
+    std::string schedule;                 // 例: "night (cooldown 300000ms) until Mon 09:00"
+    std::vector<std::pair<std::string, double>> thread_cpu_sec;  // スレッド別 CPU 時間
 };
 
+// VLM 用のメッセージ (JSON 文字列) を作成
+// trigger の use case に "details" があれば user プロンプトの {details} を置換する
+std::vector<std::string> build_prompt_messages(const json& prompts,
+                                               const std::string& trigger,
+                                               const std::string& system_prompt,
+                                               const std::string& user_prompt,
+                                               size_t num_images = 1);
+
 // =============================================================================
 class Backend {
 public:
@@ -67,7 +153,8 @@ public:
             float temperature = 0.1f,
             uint32_t seed = 42,
             int cooldown_ms = 1000,
-            int max_retries = 5);
+            int max_retries = 5,
+            const BackendOptions& options = BackendOptions());
     ~Backend();
 
     Backend(const Backend&) = delete;
@@ -80,19 +167,61 @@ public:
 
     InferenceResult vlm_custom_inference(const cv::Mat& image,
                                          const std::string& custom_prompt);
+    // 前処理して Worker のキューに積み、その promise の future を返す
+    // (完了待ちでスレッドを止めない。Worker は 60 秒の期限を過ぎた要求を
+    //  "VLM timeout" で完了させるが、Worker が固まった場合に備えて待つ側も期限を設けること)
+    std::future<InferenceResult> submit_custom_inference(const cv::Mat& image,
+                                                         const std::string& custom_prompt);
+    // 対話セッション: image を渡すと新しいセッションを開始し、
+    // 空の image で呼ぶと同じ画像への追加質問 (画像を再送せず発話のみ追加)
+    std::future<InferenceResult> submit_session_question(const cv::Mat& image,
+                                                         const std::string& prompt);
+    // コンテキストを破棄してセッションを終了 (監視再開前に呼ぶ)
+    void end_session();
+    // 複数の質問を番号付きで 1 回の生成にまとめて回答し、質問ごとに分解する
+    // 回答を取り出せなかった質問は個別に問い合わせる (session=true なら追加質問として)
+    // session=true で image が空ならセッション中の画像に対する質問
+    std::future<std::vector<InferenceResult>> submit_batch_questions(
+        const cv::Mat& image, const std::vector<std::string>& questions, bool session = false);
+    ThreadPool& executor() { return *m_pool; }
 
     void abort_current();
     void close();
     bool is_ready() const { return m_device_ready.load(); }
+    bool is_alive() const { return !m_worker_done.load(); }   // Worker が動作中 (モデル読み込み中を含む)
+    bool schedule_paused() const { return m_schedule_paused.load(); }
+    const std::string& use_case() const { return m_trigger; }
+    BackendStats stats() const;
+    // 監視結果のローリング集計 (直近 1 分 / 1 時間 / 1 日)
+    AggregateReport aggregates(AggregateSpan span) const;
     static bool diagnose_device();
+    // BGR → RGB + モデル入力サイズへのリサイズ (連続メモリ)
+    static cv::Mat preprocess_image(const cv::Mat& image, int h, int w);
 
 private:
     void worker_func();
-    cv::Mat preprocess_image(const cv::Mat& image, int h, int w);
+    std::future<InferenceResult> enqueue_custom_request(cv::Mat rgb, const std::string& prompt,
+                                                        bool session, uint32_t max_tokens = 0);
+    // 最大 60 秒待つ (期限切れは "VLM timeout")
+    InferenceResult wait_custom_result(std::future<InferenceResult> fut);
+    std::vector<InferenceResult> run_batch_questions(const cv::Mat& rgb,
+                                                     const std::vector<std::string>& questions,
+                                                     bool session, size_t n);
+    // キューに残ったカスタム推論 (と close() 時は実行中のもの) を result で完了させる
+    void fail_custom_requests(const InferenceResult& result, bool include_inflight);
+    void telemetry_func();
+    void set_telemetry_source(std::unique_ptr<TelemetrySource> src);
+    // base_ms: スケジュールで決まる基準 cooldown
+    std::chrono::milliseconds current_cooldown(
+        std::chrono::steady_clock::duration last_infer_time, int base_ms) const;
     std::vector<std::string> build_messages(
         const std::string& trigger,
         const std::string& system_prompt,
-        const std::string& user_prompt);
+        const std::string& user_prompt,
+        size_t num_images = 1);
+    std::vector<std::string> build_monitor_messages(size_t num_images);
+    // 監視レスポンスを use case の options に分類
+    std::string classify_response(const std::string& response);
 
     json m_prompts;
     std::string m_hef_path;
@@ -102,31 +231,78 @@ private:
     std::string m_trigger;
     int m_cooldown_ms;
     int m_max_retries;
+    BackendOptions m_options;
 
     std::thread m_worker;
     std::atomic<bool> m_running{true};
     std::atomic<bool> m_device_ready{false};
     std::atomic<bool> m_abort_requested{false};
     std::atomic<bool> m_worker_done{false};  // close() のタイムアウト用
+    std::atomic<bool> m_end_session{false};
 
-    std::mutex m_mtx;
+    mutable std::mutex m_mtx;
     std::condition_variable m_cv;
 
     cv::Mat m_pending_frame;
+    ForegroundStats m_pending_fg;
+    FrameScore m_pending_score;      // FrameSelect::Best のみ
+    cv::Mat m_inferred_thumb;        // 前回監視に回したフレームの縮小グレー
     bool m_has_pending = false;
+    // キャプチャスレッド (update_frame の呼び出し側) のみが触る
+    std::unique_ptr<BackgroundModel> m_bg_model;
+    // 複数フレーム推論用の履歴 (前処理済み, 古い順, 最大 multi_frames-1 枚)
+    std::deque<cv::Mat> m_frame_history;
+    std::chrono::steady_clock::time_point m_history_last_push{};
     std::atomic<bool> m_paused{false};
 
+    MonitorSchedule m_schedule;      // コンストラクタで確定 (以降は読み取りのみ)
+    std::string m_schedule_status;   // m_mtx で保護
+    std::atomic<bool> m_schedule_paused{false};
+
+    std::unique_ptr<RollingAggregates> m_aggregates;
+    std::unique_ptr<ResultPublisher> m_publisher;   // worker のみが publish する
+
     MonitoringResult m_result_buf;
     bool m_has_result = false;
 
     struct VLMReq {
-        cv::Mat image;
+        cv::Mat image;   // 前処理済み (RGB, モデル入力サイズ)
         std::string prompt;
+        bool session = false;   // true: 回答後もコンテキストを保持
+        uint32_t max_tokens = 0;   // 0 = custom_generation の設定
+        std::chrono::steady_clock::time_point deadline;   // 過ぎたら "VLM timeout"
         std::shared_ptr<std::promise<InferenceResult>> promise_ptr;
-        std::shared_ptr<std::atomic<bool>> cancelled;
+        std::shared_ptr<std::atomic<bool>> cancelled;   // true = 完了済み / 取り消し
     };
-    std::optional<VLMReq> m_vlm_req;
+    std::deque<VLMReq> m_vlm_reqs;   // 到着順に処理 (m_mtx で保護)
+    std::optional<VLMReq> m_vlm_inflight;   // 実行中の要求 (画像なし, m_mtx で保護)
+
+    std::unique_ptr<ThreadPool> m_pool;
+    // 複数の要求を順に待つバッチ質問専用 (共有エグゼキューターのスレッドを止めない)
+    std::unique_ptr<ThreadPool> m_request_pool;
 
     int m_frame_h = 336;
     int m_frame_w = 336;
+
+    // ---- テレメトリ / 熱制御 ----
+    std::thread m_telemetry;
+    // read() は遅いことがあるので、ソースの使用と公開値で mutex を分ける
+    // (stats() がサンプリング中に待たされない)
+    std::mutex m_telemetry_src_mtx;        // m_telemetry_src の使用 / 差し替え
+    std::unique_ptr<TelemetrySource> m_telemetry_src;
+    mutable std::mutex m_telemetry_mtx;    // m_telemetry_name 以下を保護
+    std::condition_variable m_telemetry_cv;
+    std::string m_telemetry_name = "none";
+    TelemetrySample m_last_sample;
+    double m_duty_cycle = 0.0;
+    uint64_t m_throttle_events = 0;
+    double m_throttled_sec = 0.0;
+    std::atomic<double> m_throttle_factor{1.0};
+    std::atomic<int64_t> m_busy_ns{0};     // 推論に費やした累計時間
+    std::atomic<uint64_t> m_inferences{0};
+    std::atomic<uint64_t> m_errors{0};
+    std::atomic<uint64_t> m_generator_recreates{0};
+    std::atomic<uint64_t> m_quality_skips[5]{};   // QualityVerdict ごと
+    std::atomic<uint64_t> m_prefilter_negatives{0};
+    std::atomic<uint64_t> m_prefilter_escalations{0};
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+// =============================================================================
+//  background_model.cpp - キャプチャスレッドで維持する軽量な背景モデル
+// =============================================================================
+
+#include "background_model.h"
+#include "trace.h"
+
+#include <algorithm>
+
+// =============================================================================
+BackgroundModel::BackgroundModel(const ForegroundConfig& cfg) : m_cfg(cfg) {}
+
+void BackgroundModel::reset() {
+    m_background.release();
+    m_frames = 0;
+}
+
+ForegroundStats BackgroundModel::update(const cv::Mat& frame) {
+    VLM_TRACE_SCOPE("bg_model");
+    ForegroundStats st;
+    if (frame.empty()) return st;
+
+    cv::Mat small = frame;
+    if (m_cfg.width > 0 && frame.cols > m_cfg.width) {
+        int h = std::max(1, frame.rows * m_cfg.width / frame.cols);
+        cv::resize(frame, small, cv::Size(m_cfg.width, h), 0, 0, cv::INTER_AREA);
+    }
+    cv::Mat gray;
+    if (small.channels() == 3) cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    else gray = small;
+
+    // 解像度が変わった (プレイリストの次の動画など) → 背景を作り直す
+    if (m_background.empty() || m_background.size() != gray.size()) {
+        gray.convertTo(m_background, CV_32F);
+        m_frames = 1;
+        return st;
+    }
+
+    cv::Mat bg8, mask;
+    m_background.convertTo(bg8, CV_8U);
+    cv::absdiff(gray, bg8, mask);
+    cv::threshold(mask, mask, m_cfg.threshold, 255, cv::THRESH_BINARY);
+    static const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+    cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
+
+    cv::accumulateWeighted(gray, m_background, m_cfg.learning_rate);
+    if (++m_frames <= m_cfg.warmup_frames) return st;
+
+    st.valid = true;
+    st.ratio = (double)cv::countNonZero(mask) / std::max(1, mask.rows * mask.cols);
+    if (st.ratio <= 0.0) return st;
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    const double sx = (double)frame.cols / mask.cols;
+    const double sy = (double)frame.rows / mask.rows;
+    const double min_area = m_cfg.min_box_area * mask.rows * mask.cols;
+    for (const auto& c : contours) {
+        cv::Rect r = cv::boundingRect(c);
+        if (r.area() < min_area) continue;
+        st.boxes.emplace_back((int)(r.x * sx), (int)(r.y * sy),
+                              (int)(r.width * sx), (int)(r.height * sy));
+    }
+    return st;
+}
@@ -0,0 +1,42 @@
+#pragma once
+// =============================================================================
+//  background_model.h - キャプチャスレッドで維持する軽量な背景モデル
+//
+//  低解像度のグレースケールで移動平均の背景を更新し、フレームごとに
+//  前景率と前景領域 (外接矩形) を出す。
+//  cooldown 中に届いたフレームのうち最も動きの多いものを推論に回すのに使う。
+// =============================================================================
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// =============================================================================
+struct ForegroundConfig {
+    int width = 160;              // 解析用の縮小幅 (px)
+    double learning_rate = 0.05;  // 背景の更新率 (移動平均)
+    int threshold = 25;           // 背景との輝度差の閾値
+    double min_box_area = 0.002;  // これより小さい前景領域は矩形にしない (画面比)
+    int warmup_frames = 10;       // 背景が落ち着くまで valid=false
+};
+
+struct ForegroundStats {
+    bool valid = false;            // 背景モデルのウォームアップ後のみ true
+    double ratio = 0.0;            // 前景画素の割合 (0..1)
+    std::vector<cv::Rect> boxes;   // 前景領域 (入力フレーム座標)
+};
+
+// =============================================================================
+class BackgroundModel {
+public:
+    explicit BackgroundModel(const ForegroundConfig& cfg = ForegroundConfig());
+
+    // フレームを 1 枚取り込み、背景を更新して前景統計を返す (BGR / グレー)
+    ForegroundStats update(const cv::Mat& frame);
+    void reset();
+
+private:
+    ForegroundConfig m_cfg;
+    cv::Mat m_background;   // CV_32F
+    int m_frames = 0;
+};
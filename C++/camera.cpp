@@ -0,0 +1,128 @@
+// =============================================================================
+//  camera.cpp - カメラの列挙とオープン
+// =============================================================================
+
+#include "camera.h"
+#include "logger.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <future>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::unique_ptr<cv::VideoCapture> probe_camera(int index, const CameraConfig& cfg) {
+    VLM_TRACE_SCOPE("camera_probe");
+    if (cfg.v4l2) {
+        auto v = std::make_unique<V4L2Capture>(cfg.v4l2_cfg);
+        if (v->open_device("/dev/video" + std::to_string(index), cfg.width, cfg.height, cfg.fps))
+            return v;
+        log_warn("Camera") << "V4L2 capture failed for camera " << index << ", using OpenCV.";
+    }
+#ifdef _WIN32
+    auto c = std::make_unique<cv::VideoCapture>(index, cv::CAP_DSHOW);
+#else
+    // V4L2 を直接指定 (CAP_ANY は GStreamer 等を先に試すことがある)
+    auto c = std::make_unique<cv::VideoCapture>(index, cv::CAP_V4L2);
+    if (!c->isOpened()) c->open(index);
+#endif
+    if (!c->isOpened()) return nullptr;
+    c->set(cv::CAP_PROP_FRAME_WIDTH, cfg.width);
+    c->set(cv::CAP_PROP_FRAME_HEIGHT, cfg.height);
+    c->set(cv::CAP_PROP_FPS, cfg.fps);
+    return c;
+}
+
+} // namespace
+
+// =============================================================================
+std::vector<CameraInfo> enumerate_cameras() {
+    std::vector<CameraInfo> out;
+#ifdef __linux__
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for (fs::directory_iterator it("/dev", ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        if (name.size() <= 5 || name.compare(0, 5, "video") != 0) continue;
+        if (!std::all_of(name.begin() + 5, name.end(), [](unsigned char ch) { return std::isdigit(ch); }))
+            continue;
+
+        const std::string path = it->path().string();
+        int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        v4l2_capability cap{};
+        const bool ok = ::ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0;
+        ::close(fd);
+        if (!ok) continue;
+        // device_caps はこのノードの機能 (capabilities は物理デバイス全体)
+        const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps
+                                                                        : cap.capabilities;
+        if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) continue;
+
+        CameraInfo info;
+        info.index = std::stoi(name.substr(5));
+        info.path = path;
+        info.name = (const char*)cap.card;
+        info.driver = (const char*)cap.driver;
+        info.bus = (const char*)cap.bus_info;
+        out.push_back(std::move(info));
+    }
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.index < b.index; });
+#endif
+    return out;
+}
+
+std::unique_ptr<cv::VideoCapture> open_camera(int preferred, int& chosen, const CameraConfig& cfg) {
+    chosen = -1;
+    std::vector<int> candidates;
+    const auto devices = enumerate_cameras();
+    for (const auto& d : devices) {
+        log_info("Camera") << d.path << ": " << d.name << " (" << d.driver << ", " << d.bus << ")";
+        candidates.push_back(d.index);
+    }
+    const bool listed = std::find(candidates.begin(), candidates.end(), preferred) != candidates.end();
+    if (devices.empty()) {
+        for (int i = 0; i < 10; i++) candidates.push_back(i);   // 列挙できない環境
+    } else if (!listed) {
+        log_warn("Camera") << "Camera " << preferred << " is not a capture device.";
+    }
+
+    // 希望のカメラが候補にあれば単独で開く (他のカメラには触れない)
+    if (devices.empty() || listed) {
+        if (auto c = probe_camera(preferred, cfg)) { chosen = preferred; return c; }
+        log_warn("Camera") << "Cannot open camera " << preferred << ", probing others.";
+    }
+    candidates.erase(std::remove(candidates.begin(), candidates.end(), preferred), candidates.end());
+    if (candidates.empty()) return nullptr;
+
+    // 列挙できない環境 (Windows の DSHOW など) は同時 open が安全とは限らないので順に試す
+    if (devices.empty()) {
+        for (int index : candidates)
+            if (auto c = probe_camera(index, cfg)) { chosen = index; return c; }
+        return nullptr;
+    }
+
+    // 列挙できた V4L2 ノードは並列に開き、最小の番号を採用 (他はすぐ閉じる)
+    std::vector<std::future<std::unique_ptr<cv::VideoCapture>>> probes;
+    std::unique_ptr<cv::VideoCapture> found;
+    {
+        ThreadPool pool(candidates.size(), ThreadPolicy(), "camera");
+        for (int index : candidates)
+            probes.push_back(pool.submit([index, &cfg] { return probe_camera(index, cfg); }));
+        for (size_t i = 0; i < probes.size(); i++) {
+            auto c = probes[i].get();
+            if (c && !found) { found = std::move(c); chosen = candidates[i]; }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// =============================================================================
+//  camera.h - カメラの列挙とオープン
+//
+//  インデックス 0〜9 を順に cv::VideoCapture で開いて閉じ、選んだカメラを
+//  もう一度開く方式では、1 回数百 ms〜数秒の open が直列に積み重なる。ここでは:
+//    - Linux は /dev/video* を VIDIOC_QUERYCAP で調べ (数 ms)、映像キャプチャ
+//      可能なノードだけを候補にする (UVC のメタデータノード等を除外)
+//    - 候補を並列に開き、希望のインデックス (無ければ最小の番号) を採用
+//    - 採用したハンドルは開いたまま返す (二重オープンなし)
+//  列挙できない環境 (Windows など) は 0〜9 を順に試す (DSHOW の同時 open は安全でない)。
+//  v4l2 = true なら V4L2Capture (mmap 直接キャプチャ) で開き、失敗時は OpenCV。
+// =============================================================================
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "v4l2_capture.h"
+
+// =============================================================================
+struct CameraInfo {
+    int index = -1;
+    std::string path;      // /dev/videoN (列挙できない環境では空)
+    std::string name;      // V4L2 card
+    std::string driver;
+    std::string bus;
+};
+
+struct CameraConfig {
+    int width = 640;
+    int height = 480;
+    int fps = 30;
+    bool v4l2 = false;     // V4L2 直接キャプチャ (Linux)
+    V4L2Config v4l2_cfg;
+};
+
+// 映像キャプチャ可能なデバイスを番号順に返す (Linux 以外は空)
+std::vector<CameraInfo> enumerate_cameras();
+
+// preferred を優先してカメラを開き、cfg の解像度 / fps を設定して返す (失敗時 nullptr)
+// chosen に採用したインデックスを入れる
+std::unique_ptr<cv::VideoCapture> open_camera(int preferred, int& chosen,
+                                              const CameraConfig& cfg = CameraConfig());
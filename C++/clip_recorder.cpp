@@ -0,0 +1,269 @@
+// =============================================================================
+//  clip_recorder.cpp - イベント前後のクリップ自動録画
+// =============================================================================
+
+#include "clip_recorder.h"
+#include "logger.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// ファイル名に使えない文字を置換
+static std::string sanitize_label(const std::string& s) {
+    std::string o;
+    for (char c : s) o += (std::isalnum((unsigned char)c) || c == '-' || c == '_') ? c : '_';
+    return o.substr(0, 48);
+}
+
+// 同じ秒に書き出したクリップが衝突しないようミリ秒まで含める
+static std::string timestamp_for_filename() {
+    const auto now = std::chrono::system_clock::now();
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count() % 1000;
+    auto t = std::chrono::system_clock::to_time_t(now);
+    struct tm b;
+#ifdef _WIN32
+    localtime_s(&b, &t);
+#else
+    localtime_r(&t, &b);
+#endif
+    std::ostringstream o;
+    o << std::put_time(&b, "%Y%m%d_%H%M%S") << "_" << std::setw(3) << std::setfill('0') << ms;
+    return o.str();
+}
+
+// =============================================================================
+ClipRecorder::ClipRecorder(const ClipConfig& cfg, ThreadPool& pool)
+    : m_cfg(cfg), m_pool(pool)
+{
+    std::error_code ec;
+    fs::create_directories(m_cfg.dir, ec);
+    if (ec) log_warn("Clip") << "Cannot create " << m_cfg.dir << ": " << ec.message();
+    log_info("Clip") << "Recording event clips to " << m_cfg.dir
+                     << " (pre " << m_cfg.pre_sec << "s, post " << m_cfg.post_sec
+                     << "s, max " << m_cfg.max_sec << "s per clip, limit " << m_cfg.max_disk_mb << "MB)";
+    m_encoder = std::thread(&ClipRecorder::encoder_loop, this);
+}
+
+ClipRecorder::~ClipRecorder() { close(); }
+
+void ClipRecorder::close() {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_encoder.joinable()) m_encoder.join();
+    for (auto& f : m_writes)
+        if (f.valid()) f.wait();
+    m_writes.clear();
+}
+
+uint64_t ClipRecorder::clips_written() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_clips_written;
+}
+
+size_t ClipRecorder::buffered_bytes() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_ring_bytes;
+}
+
+// =============================================================================
+void ClipRecorder::push(const cv::Mat& frame) {
+    if (frame.empty()) return;
+    auto now = Clock::now();
+    auto interval = std::chrono::duration<double>(1.0 / std::max(0.1, m_cfg.fps));
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running || now - m_last_push < interval) return;
+        // エンコードが追いつかない場合は捨てる (キャプチャを止めない)
+        if (m_input.size() >= 4) return;
+        m_last_push = now;
+        m_input.emplace_back(now, frame.clone());
+    }
+    m_cv.notify_one();
+}
+
+void ClipRecorder::trigger(const std::string& label) {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running) return;
+        m_pending_triggers.push_back(label);
+    }
+    m_cv.notify_one();
+}
+
+// =============================================================================
+void ClipRecorder::encoder_loop() {
+    const auto pre  = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(m_cfg.pre_sec));
+    const auto post = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(m_cfg.post_sec));
+    const auto max_len = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(m_cfg.max_sec));
+    const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, m_cfg.jpeg_quality};
+
+    for (;;) {
+        std::vector<std::string> triggers;
+        std::pair<Clock::time_point, cv::Mat> item;
+        bool running;
+        {
+            std::unique_lock<std::mutex> lk(m_mtx);
+            // 入力がなくても post 区間の終了を検出できるよう定期的に起床
+            m_cv.wait_for(lk, std::chrono::milliseconds(200), [&] {
+                return !m_running || !m_input.empty() || !m_pending_triggers.empty();
+            });
+            running = m_running;
+            triggers.swap(m_pending_triggers);
+            if (!m_input.empty()) {
+                item = std::move(m_input.front());
+                m_input.pop_front();
+            }
+        }
+        auto now = Clock::now();
+
+        // ---- 状態遷移: 録画開始 or 延長 ----
+        if (!triggers.empty()) {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            for (const auto& t : triggers) {
+                if (m_active) {
+                    m_active->end = now + post;
+                } else {
+                    m_active = std::make_unique<ActiveClip>();
+                    m_active->label = t;
+                    m_active->end = now + post;
+                    m_active->frames.assign(m_ring.begin(), m_ring.end());
+                    m_active->start = m_ring.empty() ? now : m_ring.front().ts;
+                    log_info("Clip") << "Event \"" << t << "\" - recording ("
+                                     << m_ring.size() << " pre-event frames)";
+                }
+            }
+        }
+
+        // ---- 縮小 + JPEG エンコード (ロック外) ----
+        if (!item.second.empty()) {
+            cv::Mat small = item.second;
+            if (m_cfg.max_width > 0 && small.cols > m_cfg.max_width) {
+                double s = (double)m_cfg.max_width / small.cols;
+                cv::resize(small, small, cv::Size(m_cfg.max_width, (int)(small.rows * s)),
+                           0, 0, cv::INTER_AREA);
+            }
+            auto jpeg = std::make_shared<std::vector<uchar>>();
+            if (cv::imencode(".jpg", small, *jpeg, params)) {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                m_ring.push_back({item.first, jpeg});
+                m_ring_bytes += jpeg->size();
+                while (!m_ring.empty() && m_ring.front().ts < now - pre) {
+                    m_ring_bytes -= m_ring.front().jpeg->size();
+                    m_ring.pop_front();
+                }
+                if (m_active) m_active->frames.push_back(m_ring.back());
+            }
+        }
+
+        // ---- post 区間終了 (または終了時) → 書き出し ----
+        std::unique_ptr<ActiveClip> done;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_active && (now >= m_active->end || !running)) {
+                done = std::move(m_active);
+            } else if (m_active && m_cfg.max_sec > 0 && now - m_active->start >= max_len) {
+                // 状態遷移が続いて終わらない: ここで区切り、続きを次のクリップに録る
+                done = std::move(m_active);
+                m_active = std::make_unique<ActiveClip>();
+                m_active->label = done->label;
+                m_active->start = now;
+                m_active->end = done->end;
+                m_active->part = done->part + 1;
+                log_info("Clip") << "Event \"" << done->label << "\" longer than " << m_cfg.max_sec
+                                 << "s - continuing in part " << m_active->part;
+            }
+        }
+        if (done) {
+            auto clip = std::make_shared<ActiveClip>(std::move(*done));
+            try {
+                m_writes.push_back(m_pool.submit([this, clip] { write_clip(std::move(*clip)); }));
+            } catch (const std::exception&) {
+                write_clip(std::move(*clip));   // エグゼキューター停止後は同期で書き出す
+            }
+            // 完了済みの future を整理
+            m_writes.erase(std::remove_if(m_writes.begin(), m_writes.end(), [](std::future<void>& f) {
+                return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            }), m_writes.end());
+        }
+
+        if (!running) {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_input.empty()) break;
+        }
+    }
+}
+
+// =============================================================================
+void ClipRecorder::write_clip(ActiveClip clip) {
+    if (clip.frames.empty()) return;
+
+    fs::path path = fs::path(m_cfg.dir) /
+        ("clip_" + timestamp_for_filename() + "_" + sanitize_label(clip.label) +
+         (clip.part > 1 ? "_part" + std::to_string(clip.part) : "") + ".avi");
+
+    cv::VideoWriter writer;
+    size_t n = 0;
+    for (const auto& f : clip.frames) {
+        cv::Mat img = cv::imdecode(*f.jpeg, cv::IMREAD_COLOR);
+        if (img.empty()) continue;
+        if (!writer.isOpened()) {
+            writer.open(path.string(), cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                        m_cfg.fps, cv::Size(img.cols, img.rows));
+            if (!writer.isOpened()) {
+                log_warn("Clip") << "Cannot open " << path.string();
+                return;
+            }
+        }
+        writer.write(img);
+        n++;
+    }
+    writer.release();
+
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_clips_written++;
+    }
+    log_info("Clip") << "Saved " << path.filename().string() << " (" << n << " frames)";
+    enforce_disk_budget();
+}
+
+void ClipRecorder::enforce_disk_budget() {
+    std::lock_guard<std::mutex> lk(m_disk_mtx);
+    std::error_code ec;
+    std::vector<std::pair<fs::file_time_type, fs::path>> clips;
+    uintmax_t total = 0;
+    for (const auto& e : fs::directory_iterator(m_cfg.dir, ec)) {
+        if (!e.is_regular_file()) continue;
+        auto name = e.path().filename().string();
+        if (name.rfind("clip_", 0) != 0) continue;
+        total += e.file_size(ec);
+        clips.emplace_back(e.last_write_time(ec), e.path());
+    }
+    const uintmax_t limit = (uintmax_t)(m_cfg.max_disk_mb * 1024.0 * 1024.0);
+    if (total <= limit) return;
+
+    std::sort(clips.begin(), clips.end());   // 古い順
+    for (const auto& [t, p] : clips) {
+        if (total <= limit) break;
+        uintmax_t sz = fs::file_size(p, ec);
+        if (fs::remove(p, ec)) {
+            total -= sz;
+            log_info("Clip") << "Disk budget: removed " << p.filename().string();
+        }
+    }
+}
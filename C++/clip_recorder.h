@@ -0,0 +1,103 @@
+#pragma once
+// =============================================================================
+//  clip_recorder.h - イベント前後のクリップ自動録画
+//
+//  直近 pre_sec 秒のフレームを縮小 + JPEG 圧縮してリングバッファに保持し、
+//  監視結果の状態遷移 (例: empty → pickup) でイベント前後のクリップを書き出す。
+//  24 時間録画せずにイベントの文脈だけを残す。
+//
+//  - push() は間引き判定とコピーのみ (エンコードは専用スレッド)
+//  - クリップの書き出しは共有エグゼキューターで実行
+//  - 保存先の合計サイズが max_disk_mb を超えたら古いクリップから削除
+//  - 状態遷移が続いても max_sec ごとに区切って書き出す (メモリを抑える)
+// =============================================================================
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+class ThreadPool;
+
+// =============================================================================
+struct ClipConfig {
+    std::string dir;              // 空 = 無効
+    double pre_sec = 5.0;         // イベント前
+    double post_sec = 5.0;        // イベント後
+    double fps = 5.0;             // バッファへの取り込みレート
+    int max_width = 640;          // エンコード前に縮小
+    int jpeg_quality = 80;
+    double max_disk_mb = 1024.0;  // クリップ合計サイズの上限
+    double max_sec = 60.0;        // 1 クリップの最長 (超えたら続きを次のクリップに。0 = 無制限)
+
+    bool enabled() const { return !dir.empty(); }
+};
+
+// =============================================================================
+class ClipRecorder {
+public:
+    ClipRecorder(const ClipConfig& cfg, ThreadPool& pool);
+    ~ClipRecorder();
+
+    ClipRecorder(const ClipRecorder&) = delete;
+    ClipRecorder& operator=(const ClipRecorder&) = delete;
+
+    // キャプチャスレッドから毎フレーム呼ぶ (fps を超える分は捨てる)
+    void push(const cv::Mat& frame);
+
+    // 状態遷移を通知 (録画中なら post 区間を延長)
+    void trigger(const std::string& label);
+
+    void close();
+
+    uint64_t clips_written() const;
+    size_t buffered_bytes() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct EncodedFrame {
+        Clock::time_point ts;
+        std::shared_ptr<std::vector<uchar>> jpeg;
+    };
+
+    struct ActiveClip {
+        std::string label;
+        Clock::time_point start;   // 先頭フレームの時刻
+        Clock::time_point end;
+        int part = 1;              // max_sec で区切った続きは 2, 3, ...
+        std::vector<EncodedFrame> frames;
+    };
+
+    void encoder_loop();
+    void write_clip(ActiveClip clip);
+    void enforce_disk_budget();
+
+    ClipConfig m_cfg;
+    ThreadPool& m_pool;
+
+    std::thread m_encoder;
+    bool m_running = true;
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+
+    std::deque<std::pair<Clock::time_point, cv::Mat>> m_input;   // 未エンコード
+    Clock::time_point m_last_push{};
+
+    std::deque<EncodedFrame> m_ring;       // pre 区間
+    size_t m_ring_bytes = 0;
+    std::vector<std::string> m_pending_triggers;
+    std::unique_ptr<ActiveClip> m_active;
+
+    std::mutex m_disk_mtx;                 // 書き出しタスク間の削除処理を直列化
+    std::vector<std::future<void>> m_writes;   // close() で完了を待つ
+    uint64_t m_clips_written = 0;
+};
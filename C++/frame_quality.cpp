@@ -0,0 +1,55 @@
+// =============================================================================
+//  frame_quality.cpp - 推論前のフレーム品質チェック
+// =============================================================================
+
+#include "frame_quality.h"
+#include "trace.h"
+
+#include <algorithm>
+
+// =============================================================================
+FrameQuality measure_frame_quality(const cv::Mat& frame, int analysis_width) {
+    VLM_TRACE_SCOPE("quality");
+    FrameQuality q;
+    if (frame.empty()) return q;
+
+    // 先に縮小してから変換 (フル解像度のグレー変換を避ける)
+    cv::Mat small = frame;
+    if (analysis_width > 0 && frame.cols > analysis_width) {
+        int h = std::max(1, frame.rows * analysis_width / frame.cols);
+        cv::resize(frame, small, cv::Size(analysis_width, h), 0, 0, cv::INTER_AREA);
+    }
+    cv::Mat gray;
+    if (small.channels() == 3) cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    else gray = small;
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(gray, mean, stddev);
+    q.luma = mean[0];
+    q.contrast = stddev[0];
+
+    cv::Mat lap;
+    cv::Laplacian(gray, lap, CV_64F);
+    cv::meanStdDev(lap, mean, stddev);
+    q.sharpness = stddev[0] * stddev[0];
+    return q;
+}
+
+QualityVerdict judge_frame_quality(const FrameQuality& q, const QualityConfig& cfg) {
+    if (q.luma < cfg.min_luma) return QualityVerdict::Dark;
+    if (q.luma > cfg.max_luma) return QualityVerdict::Overexposed;
+    if (q.contrast < cfg.min_contrast) return QualityVerdict::LowContrast;
+    if (q.sharpness < cfg.min_sharpness) return QualityVerdict::Blurred;
+    return QualityVerdict::Ok;
+}
+
+const char* quality_verdict_name(QualityVerdict v) {
+    switch (v) {
+        case QualityVerdict::Ok:          return "ok";
+        case QualityVerdict::Dark:        return "dark";
+        case QualityVerdict::Overexposed: return "overexposed";
+        case QualityVerdict::LowContrast: return "low_contrast";
+        case QualityVerdict::Blurred:     return "blurred";
+    }
+    return "?";
+}
@@ -0,0 +1,41 @@
+#pragma once
+// =============================================================================
+//  frame_quality.h - 推論前のフレーム品質チェック
+//
+//  夜間の真っ黒なフレーム、白飛び、動きブレのフレームは VLM に送っても
+//  意味のない回答になり、1 サイクル (数秒) を無駄にする。
+//  縮小したグレースケールで以下を測り、閾値を下回るフレームは推論しない:
+//    - 平均輝度       (暗すぎ / 明るすぎ)
+//    - 輝度の標準偏差 (コントラスト不足: 霧、レンズキャップ、単色)
+//    - ラプラシアン分散 (ブレ / ピンボケ)
+// =============================================================================
+
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+// =============================================================================
+struct QualityConfig {
+    bool enabled = false;
+    double min_luma = 20.0;        // 平均輝度 (0..255)
+    double max_luma = 235.0;
+    double min_contrast = 10.0;    // 輝度の標準偏差
+    double min_sharpness = 30.0;   // ラプラシアン分散 (analysis_width 基準)
+    int analysis_width = 160;      // 計測用の縮小幅 (px)
+};
+
+struct FrameQuality {
+    double luma = 0.0;
+    double contrast = 0.0;
+    double sharpness = 0.0;
+};
+
+enum class QualityVerdict { Ok, Dark, Overexposed, LowContrast, Blurred };
+
+// 縮小グレースケールで計測 (BGR / グレー)
+FrameQuality measure_frame_quality(const cv::Mat& frame, int analysis_width = 160);
+
+// 最初に引っかかった閾値を返す (暗さ → 白飛び → コントラスト → ブレ の順)
+QualityVerdict judge_frame_quality(const FrameQuality& q, const QualityConfig& cfg);
+
+const char* quality_verdict_name(QualityVerdict v);
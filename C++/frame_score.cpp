@@ -0,0 +1,45 @@
+// =============================================================================
+//  frame_score.cpp - cooldown 中の候補フレームの採点 (ベストフレーム選択)
+// =============================================================================
+
+#include "frame_score.h"
+#include "frame_quality.h"
+#include "trace.h"
+
+#include <algorithm>
+
+namespace {
+constexpr int kThumbWidth = 64;
+// 正規化の目安 (この値で 0.5 / 1.0 になる)
+constexpr double kSharpnessHalf = 100.0;   // ラプラシアン分散 (160px 基準)
+constexpr double kForegroundFull = 0.05;   // 前景率 5% で満点
+constexpr double kChangeFull = 32.0;       // 平均輝度差 32 で満点
+}
+
+// =============================================================================
+FrameScore score_frame(const cv::Mat& frame, const ForegroundStats& fg,
+                       const cv::Mat& reference, const FrameScoreWeights& w)
+{
+    VLM_TRACE_SCOPE("frame_score");
+    FrameScore s;
+    if (frame.empty()) return s;
+
+    const FrameQuality q = measure_frame_quality(frame, 160);
+    s.sharpness = q.sharpness / (q.sharpness + kSharpnessHalf);
+    s.foreground = fg.valid ? std::min(1.0, fg.ratio / kForegroundFull) : 0.0;
+
+    cv::Mat small;
+    int h = std::max(1, frame.rows * kThumbWidth / std::max(1, frame.cols));
+    cv::resize(frame, small, cv::Size(kThumbWidth, h), 0, 0, cv::INTER_AREA);
+    if (small.channels() == 3) cv::cvtColor(small, s.thumb, cv::COLOR_BGR2GRAY);
+    else s.thumb = small;
+
+    if (!reference.empty() && reference.size() == s.thumb.size()) {
+        cv::Mat diff;
+        cv::absdiff(s.thumb, reference, diff);
+        s.change = std::min(1.0, cv::mean(diff)[0] / kChangeFull);
+    }
+
+    s.total = w.sharpness * s.sharpness + w.foreground * s.foreground + w.change * s.change;
+    return s;
+}
@@ -0,0 +1,33 @@
+#pragma once
+// =============================================================================
+//  frame_score.h - cooldown 中の候補フレームの採点 (ベストフレーム選択)
+//
+//  キャプチャのたびに安価な指標で採点し、最高点のフレームだけを保持する
+//  (全フレームを溜めない)。指標はそれぞれ 0..1 に正規化して重み付き和をとる:
+//    - sharpness  : ラプラシアン分散 (ブレていない)
+//    - foreground : 背景モデルの前景率 (動きがある)
+//    - change     : 前回推論したフレームとの差 (新しい情報がある)
+// =============================================================================
+
+#include <opencv2/opencv.hpp>
+
+#include "background_model.h"
+
+// =============================================================================
+struct FrameScoreWeights {
+    double sharpness = 1.0;
+    double foreground = 1.0;
+    double change = 1.0;
+};
+
+struct FrameScore {
+    double total = 0.0;
+    double sharpness = 0.0;    // 各項は正規化後 (0..1)
+    double foreground = 0.0;
+    double change = 0.0;
+    cv::Mat thumb;             // 比較用の縮小グレー (推論されたら次の基準になる)
+};
+
+// reference: 前回推論したフレームの thumb (空なら change = 0)
+FrameScore score_frame(const cv::Mat& frame, const ForegroundStats& fg,
+                       const cv::Mat& reference, const FrameScoreWeights& w);
@@ -0,0 +1,260 @@
+// =============================================================================
+//  logger.cpp - 非同期ロガー (ロックフリーキュー + バックグラウンド書き込み)
+//
+//  キューは Vyukov 方式の有界 MPSC リングバッファ:
+//    各スロットのシーケンス番号で空き/使用中を判定し、投入は CAS のみ。
+// =============================================================================
+
+#include "logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// =============================================================================
+bool parse_log_level(const std::string& s, LogLevel& out) {
+    if (s == "debug")      out = LogLevel::Debug;
+    else if (s == "info")  out = LogLevel::Info;
+    else if (s == "warn")  out = LogLevel::Warn;
+    else if (s == "error") out = LogLevel::Error;
+    else return false;
+    return true;
+}
+
+static const char* level_name(LogLevel lv) {
+    switch (lv) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info:  return "info";
+        case LogLevel::Warn:  return "warn";
+        case LogLevel::Error: return "error";
+    }
+    return "info";
+}
+
+static void append_json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char b[8];
+                    std::snprintf(b, sizeof(b), "\\u%04x", c);
+                    out += b;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// =============================================================================
+Logger& Logger::instance() {
+    static Logger* inst = [] {
+        auto* l = new Logger();
+        std::atexit([] { Logger::instance().shutdown(); });
+        return l;
+    }();
+    return *inst;
+}
+
+Logger::Logger() {
+    configure(LogLevel::Info, false, 4096);
+    start();
+}
+
+void Logger::configure(LogLevel level, bool json, size_t queue_capacity) {
+    m_level.store(level, std::memory_order_relaxed);
+    m_json.store(json, std::memory_order_relaxed);
+    if (m_slots && (m_mask + 1) >= queue_capacity) return;   // 縮小はしない
+
+    // 容量は 2 のべき乗に切り上げ
+    size_t cap = 1;
+    while (cap < queue_capacity) cap <<= 1;
+
+    bool was_running = m_running.load();
+    if (was_running) shutdown();
+    m_slots.reset(new Slot[cap]);
+    for (size_t i = 0; i < cap; i++) m_slots[i].seq.store(i, std::memory_order_relaxed);
+    m_mask = cap - 1;
+    m_head = 0;
+    m_tail = 0;
+    m_written = 0;
+    if (was_running) start();
+}
+
+void Logger::start() {
+    m_running = true;
+    m_flusher = std::thread(&Logger::flusher_loop, this);
+}
+
+// =============================================================================
+bool Logger::try_push(Record&& r) {
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &m_slots[pos & m_mask];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return false;   // 満杯
+        } else {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+    slot->rec = std::move(r);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool Logger::try_pop(Record& r) {
+    Slot& slot = m_slots[m_tail & m_mask];
+    size_t seq = slot.seq.load(std::memory_order_acquire);
+    if ((intptr_t)seq - (intptr_t)(m_tail + 1) < 0) return false;
+    r = std::move(slot.rec);
+    slot.seq.store(m_tail + m_mask + 1, std::memory_order_release);
+    m_tail++;
+    return true;
+}
+
+void Logger::submit(Record&& r) {
+    r.ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (!m_running.load(std::memory_order_acquire)) {
+        // shutdown 後 (atexit 以降など) は同期出力
+        std::lock_guard<std::mutex> lk(m_sync_mtx);
+        std::string out, err;
+        write_record(r, out, err);
+        if (!out.empty()) { std::fwrite(out.data(), 1, out.size(), stdout); std::fflush(stdout); }
+        if (!err.empty()) { std::fwrite(err.data(), 1, err.size(), stderr); std::fflush(stderr); }
+        return;
+    }
+
+    if (!try_push(std::move(r))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (m_consumer_waiting.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lk(m_wait_mtx);
+        m_wait_cv.notify_one();
+    }
+}
+
+void Logger::flush() {
+    if (!m_running.load()) return;
+    size_t target = m_head.load();
+    std::unique_lock<std::mutex> lk(m_wait_mtx);
+    m_wait_cv.notify_one();
+    m_flushed_cv.wait_for(lk, std::chrono::seconds(2),
+                          [&] { return m_written.load() >= target || !m_running.load(); });
+}
+
+void Logger::shutdown() {
+    if (!m_running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lk(m_wait_mtx);
+        m_wait_cv.notify_one();
+    }
+    if (m_flusher.joinable()) m_flusher.join();
+}
+
+// =============================================================================
+void Logger::write_record(const Record& r, std::string& out, std::string& err) {
+    std::string& dst = (r.level >= LogLevel::Warn && !r.raw) ? err : out;
+
+    if (r.raw) {
+        dst += r.text;
+        if (!r.text.empty()) m_mid_line = r.text.back() != '\n';
+        return;
+    }
+    // raw 出力 (トークン表示) の途中なら改行してから出力
+    if (m_mid_line) { out += '\n'; m_mid_line = false; }
+
+    if (m_json.load(std::memory_order_relaxed)) {
+        dst += "{\"ts\":" + std::to_string(r.ts_ms) + ",\"level\":\"" + level_name(r.level) + "\"";
+        if (!r.tag.empty()) { dst += ",\"tag\":"; append_json_string(dst, r.tag); }
+        dst += ",\"msg\":";
+        append_json_string(dst, r.text);
+        for (const auto& [k, v] : r.fields) {
+            dst += ',';
+            append_json_string(dst, k);
+            dst += ':';
+            append_json_string(dst, v);
+        }
+        dst += "}\n";
+        return;
+    }
+
+    if (!r.tag.empty()) dst += "[" + r.tag + "] ";
+    dst += r.text;
+    for (const auto& [k, v] : r.fields) dst += " " + k + "=" + v;
+    dst += '\n';
+}
+
+void Logger::flusher_loop() {
+    std::string out, err;
+    Record r;
+    for (;;) {
+        size_t n = 0;
+        while (try_pop(r)) {
+            write_record(r, out, err);
+            n++;
+            if (out.size() + err.size() > 64 * 1024) break;
+        }
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_dropped_reported) {
+            err += "[Logger] " + std::to_string(dropped - m_dropped_reported)
+                 + " messages dropped (queue full)\n";
+            m_dropped_reported = dropped;
+        }
+
+        // 1 バッチにつき 1 回の write/flush
+        if (!out.empty()) { std::fwrite(out.data(), 1, out.size(), stdout); std::fflush(stdout); out.clear(); }
+        if (!err.empty()) { std::fwrite(err.data(), 1, err.size(), stderr); std::fflush(stderr); err.clear(); }
+
+        if (n > 0) {
+            m_written.fetch_add(n);
+            std::lock_guard<std::mutex> lk(m_wait_mtx);
+            m_flushed_cv.notify_all();
+            continue;
+        }
+        if (!m_running.load()) break;
+
+        std::unique_lock<std::mutex> lk(m_wait_mtx);
+        m_consumer_waiting = true;
+        // フラグを立てた後に再確認 (直前の投入の取りこぼし防止)
+        const Slot& next = m_slots[m_tail & m_mask];
+        if ((intptr_t)next.seq.load(std::memory_order_acquire) - (intptr_t)(m_tail + 1) < 0)
+            m_wait_cv.wait_for(lk, std::chrono::milliseconds(50));
+        m_consumer_waiting = false;
+    }
+    // 終了時に残っているものを書き出す
+    while (try_pop(r)) {
+        write_record(r, out, err);
+        m_written.fetch_add(1);
+    }
+    if (!out.empty()) std::fwrite(out.data(), 1, out.size(), stdout);
+    if (!err.empty()) std::fwrite(err.data(), 1, err.size(), stderr);
+    std::fflush(stdout);
+    std::fflush(stderr);
+    std::lock_guard<std::mutex> lk(m_wait_mtx);
+    m_flushed_cv.notify_all();
+}
+
+// =============================================================================
+void log_raw(const std::string& text) {
+    Logger::Record r;
+    r.raw = true;
+    r.text = text;
+    Logger::instance().submit(std::move(r));
+}
@@ -0,0 +1,147 @@
+#pragma once
+// =============================================================================
+//  logger.h - 非同期ロガー (ロックフリーキュー + バックグラウンド書き込み)
+//
+//  Worker / UI スレッドから std::cout << ... << std::endl で同期出力すると、
+//  stdout が遅いパイプやシリアルコンソールの場合にパイプラインが止まる。
+//  ログ呼び出しはリングバッファへの投入のみで戻り、書き込みは専用スレッドが
+//  まとめて行う。キューが満杯の場合は破棄して件数を数える (呼び出し側は待たない)。
+//
+//  使い方:
+//    log_info("Backend") << "VDevice OK.";
+//    log_warn("Backend").field("status", st) << "VLM::create failed";
+//    log_raw(token);            // 改行/タグなし (トークンのストリーム表示)
+//    log_flush();               // 標準入力を読む前にプロンプトを確実に出す
+// =============================================================================
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+enum class LogLevel { Debug = 0, Info, Warn, Error };
+
+bool parse_log_level(const std::string& s, LogLevel& out);
+
+// =============================================================================
+class Logger {
+public:
+    struct Record {
+        LogLevel level = LogLevel::Info;
+        bool raw = false;                 // タグ/改行を付けずにそのまま出力
+        int64_t ts_ms = 0;                // UNIX 時刻 (JSON 出力用)
+        std::string tag;
+        std::string text;
+        std::vector<std::pair<std::string, std::string>> fields;
+    };
+
+    // プロセス終了まで破棄しない (detach されたスレッドからの出力に備える)
+    static Logger& instance();
+
+    // 起動前に設定する
+    void configure(LogLevel level, bool json, size_t queue_capacity);
+
+    bool enabled(LogLevel lv) const { return lv >= m_level.load(std::memory_order_relaxed); }
+    void submit(Record&& r);
+
+    // ここまでに投入されたレコードが書き込まれるまで待つ
+    void flush();
+    // 残りを書き出して書き込みスレッドを終了 (以降は同期出力)
+    void shutdown();
+
+    uint64_t dropped() const { return m_dropped.load(); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        Record rec;
+    };
+
+    Logger();
+    void start();
+    bool try_push(Record&& r);
+    bool try_pop(Record& r);
+    void flusher_loop();
+    void write_record(const Record& r, std::string& out_buf, std::string& err_buf);
+
+    // configure() は書き込みスレッドの動作中にも呼ばれる
+    std::atomic<LogLevel> m_level{LogLevel::Info};
+    std::atomic<bool> m_json{false};
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    std::atomic<size_t> m_head{0};    // 投入位置 (複数プロデューサー)
+    size_t m_tail = 0;                // 取り出し位置 (書き込みスレッドのみ)
+
+    std::thread m_flusher;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_consumer_waiting{false};
+    std::mutex m_wait_mtx;
+    std::condition_variable m_wait_cv;       // 書き込みスレッドの起床
+    std::condition_variable m_flushed_cv;    // flush() 待ち
+    std::atomic<size_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+    uint64_t m_dropped_reported = 0;
+
+    std::mutex m_sync_mtx;                   // shutdown 後の同期出力
+    bool m_mid_line = false;                 // raw 出力で行の途中にいる
+};
+
+// =============================================================================
+//  LogLine - ストリーム形式で組み立て、破棄時に投入
+// =============================================================================
+class LogLine {
+public:
+    LogLine(LogLevel level, const char* tag)
+        : m_active(Logger::instance().enabled(level))
+    {
+        if (m_active) { m_rec.level = level; m_rec.tag = tag; }
+    }
+    ~LogLine() {
+        if (m_active) {
+            m_rec.text = m_ss.str();
+            Logger::instance().submit(std::move(m_rec));
+        }
+    }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template <class T>
+    LogLine& operator<<(const T& v) { if (m_active) m_ss << v; return *this; }
+    LogLine& operator<<(std::ios_base& (*manip)(std::ios_base&)) {
+        if (m_active) m_ss << manip;
+        return *this;
+    }
+
+    template <class T>
+    LogLine& field(const std::string& key, const T& v) {
+        if (m_active) {
+            std::ostringstream o;
+            o << v;
+            m_rec.fields.emplace_back(key, o.str());
+        }
+        return *this;
+    }
+
+private:
+    bool m_active;
+    Logger::Record m_rec;
+    std::ostringstream m_ss;
+};
+
+inline LogLine log_debug(const char* tag) { return LogLine(LogLevel::Debug, tag); }
+inline LogLine log_info(const char* tag)  { return LogLine(LogLevel::Info, tag); }
+inline LogLine log_warn(const char* tag)  { return LogLine(LogLevel::Warn, tag); }
+inline LogLine log_error(const char* tag) { return LogLine(LogLevel::Error, tag); }
+
+// 改行/タグなしの出力 (トークンのストリーム表示、対話プロンプト)
+void log_raw(const std::string& text);
+inline void log_flush() { Logger::instance().flush(); }
@@ -1,11 +1,21 @@
 // =============================================================================
 //  main.cpp - VLM カメラ/動画アプリケーション (Windows/Linux)
 //
-//  入力: USBカメラ / 動画ファイル / フォルダー内の全動画
+//  入力: USBカメラ / 動画ファイル / フォルダー内の全動画 / 静止画フォルダーの監視 (--watch)
 //  終了: 'q' キーまたは Ctrl+C
 // =============================================================================
 
 #include "backend.h"
+#include "camera.h"
+#include "clip_recorder.h"
+#include "logger.h"
+#include "mosaic.h"
+#include "playlist.h"
+#include "profile.h"
+#include "soak.h"
+#include "thread_util.h"
+#include "video_writer.h"
+#include "watch_folder.h"
 
 #include <iostream>
 #include <fstream>
@@ -18,6 +28,7 @@
 #include <sstream>
 #include <filesystem>
 #include <algorithm>
+#include <cstdio>
 
 namespace fs = std::filesystem;
 
@@ -36,6 +47,21 @@ static bool check_enter() {
     if (_kbhit()) { int ch = _getch(); if (ch == '\r' || ch == '\n') return true; }
     return false;
 }
+// ノンブロッキングで 1 行読む (入力中の文字はエコーして保持)
+static bool poll_line(std::string& out) {
+    static std::string buf;
+    while (_kbhit()) {
+        int ch = _getch();
+        if (ch == '\r' || ch == '\n') { _putch('\n'); out.swap(buf); buf.clear(); return true; }
+        if (ch == '\b') {
+            if (!buf.empty()) { buf.pop_back(); _putch('\b'); _putch(' '); _putch('\b'); }
+            continue;
+        }
+        buf += (char)ch;
+        _putch(ch);
+    }
+    return false;
+}
 #else
 static bool check_enter() {
     fd_set fds; FD_ZERO(&fds); FD_SET(STDIN_FILENO, &fds);
@@ -45,10 +71,31 @@ static bool check_enter() {
     }
     return false;
 }
+static bool poll_line(std::string& out) {
+    fd_set fds; FD_ZERO(&fds); FD_SET(STDIN_FILENO, &fds);
+    struct timeval tv = {0, 0};
+    if (select(STDIN_FILENO + 1, &fds, nullptr, nullptr, &tv) > 0) {
+        std::getline(std::cin, out); return true;
+    }
+    return false;
+}
 #endif
 
 static std::string read_line() { std::string l; std::getline(std::cin, l); return l; }
 
+// "How many people?; Is the shelf empty?" → 質問ごとに分割
+static std::vector<std::string> split_questions(const std::string& line) {
+    std::vector<std::string> out;
+    std::stringstream ss(line);
+    std::string q;
+    while (std::getline(ss, q, ';')) {
+        auto l = q.find_first_not_of(" \t");
+        auto r = q.find_last_not_of(" \t\r");
+        if (l != std::string::npos) out.push_back(q.substr(l, r - l + 1));
+    }
+    return out;
+}
+
 static std::string now_str() {
     auto t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     struct tm b;
@@ -60,20 +107,6 @@ static std::string now_str() {
     std::ostringstream o; o << std::put_time(&b, "%H:%M:%S"); return o.str();
 }
 
-static int find_camera(int pref) {
-    auto try_cam = [](int id) {
-#ifdef _WIN32
-        cv::VideoCapture c(id, cv::CAP_DSHOW);
-#else
-        cv::VideoCapture c(id);
-#endif
-        bool ok = c.isOpened(); if (ok) c.release(); return ok;
-    };
-    if (try_cam(pref)) return pref;
-    for (int i = 0; i < 10; i++) if (i != pref && try_cam(i)) return i;
-    return -1;
-}
-
 // =============================================================================
 //  動画ファイル一覧を取得 (ファイルまたはフォルダー)
 // =============================================================================
@@ -116,104 +149,176 @@ static cv::Mat scale_for_display(const cv::Mat& frame, double scale) {
 class App {
 public:
     App(const json& prompts, int cam, const std::string& video_path,
-        const std::string& hef, int cooldown_ms, double display_scale)
+        const std::string& hef, int cooldown_ms, double display_scale,
+        const BackendOptions& options, const SoakConfig& soak,
+        const ThreadPolicy& capture_policy, const std::string& trace_path,
+        const ClipConfig& clip, const std::string& output_video, size_t output_queue,
+        int aggregate_interval_s, const WatchConfig& watch, const CameraConfig& camera)
         : m_backend(prompts, hef,
                     /*max_tokens=*/15, /*temp=*/0.1f,
-                    /*seed=*/42, cooldown_ms)
+                    /*seed=*/42, cooldown_ms, /*max_retries=*/5, options)
         , m_cam_id(cam)
         , m_video_path(video_path)
         , m_scale(display_scale)
-    {}
+        , m_soak_cfg(soak)
+        , m_headless(soak.enabled())
+        , m_capture_policy(capture_policy)
+        , m_trace_path(trace_path)
+        , m_aggregate_interval_s(aggregate_interval_s)
+        , m_watch_cfg(watch)
+        , m_camera_cfg(camera)
+    {
+        // クリップの書き出しは Backend の共有エグゼキューターで行う
+        if (clip.enabled())
+            m_clips = std::make_unique<ClipRecorder>(clip, m_backend.executor());
+        if (!output_video.empty())
+            m_video_out = std::make_unique<AnnotatedVideoWriter>(output_video, output_queue);
+    }
 
-    void run() {
+    // 戻り値: 終了コード (ソーク FAIL 時は 2)
+    int run() {
         std::signal(SIGINT, signal_handler);
+        // このスレッドがキャプチャ/表示ループを担当する
+        ThreadCpuScope cpu("capture");
+        apply_thread_policy(m_capture_policy, "capture");
 
-        std::cout << "Waiting for Hailo device..." << std::endl;
+        log_info("") << "Waiting for Hailo device...";
         for (int i = 0; i < 80 && !m_backend.is_ready() && g_running; i++) {
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
             if (i > 0 && i % 10 == 0)
-                std::cout << "  (" << (i / 2) << "s)" << std::endl;
+                log_info("") << "  (" << (i / 2) << "s)";
         }
         if (!m_backend.is_ready())
-            std::cerr << "WARNING: Device not ready." << std::endl;
+            log_warn("") << "WARNING: Device not ready.";
+
+        if (m_watch_cfg.enabled()) return run_watch();
 
         // ---- 入力ソース ----
         auto video_files = resolve_video_sources(m_video_path);
         bool use_video = !video_files.empty();
 
-        cv::VideoCapture cap;
-        size_t video_idx = 0;
+        std::unique_ptr<cv::VideoCapture> camera;
+        std::unique_ptr<PlaylistPlayer> playlist;  // 動画 (次のファイルを先読み)
+        auto source = [&]() -> const cv::VideoCapture& { return playlist ? playlist->capture() : *camera; };
 
         if (use_video) {
-            std::cout << "Playlist (" << video_files.size() << " files):" << std::endl;
+            log_info("") << "Playlist (" << video_files.size() << " files):";
             for (size_t i = 0; i < video_files.size(); i++)
-                std::cout << "  [" << i << "] " << video_files[i] << std::endl;
-            cap.open(video_files[0]);
-            if (!cap.isOpened()) {
-                std::cerr << "Cannot open: " << video_files[0] << std::endl;
-                return;
-            }
-            std::cout << format_video_info(cap, video_files[0]) << std::endl;
+                log_info("") << "  [" << i << "] " << video_files[i];
+            playlist = std::make_unique<PlaylistPlayer>(video_files, m_backend.executor());
+            if (!playlist->open()) return 1;
+            log_info("") << format_video_info(playlist->capture(), video_files[0]);
         } else {
-            int cam = find_camera(m_cam_id);
-            if (cam < 0) { std::cerr << "No camera." << std::endl; return; }
-#ifdef _WIN32
-            cap.open(cam, cv::CAP_DSHOW);
-#else
-            cap.open(cam);
-#endif
-            cap.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-            cap.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
-            cap.set(cv::CAP_PROP_FPS, 30);
-            if (!cap.isOpened()) { std::cerr << "Cannot open camera." << std::endl; return; }
+            // 開いたハンドルをそのまま使う (選んだ後に開き直さない)
+            int cam = -1;
+            camera = open_camera(m_cam_id, cam, m_camera_cfg);
+            if (!camera) { log_error("") << "No camera."; return 1; }
+            log_info("") << "Camera " << cam << " opened.";
         }
 
-        int wait_ms = calc_wait_ms(cap, use_video);
+        int wait_ms = calc_wait_ms(source(), use_video);
+        double out_fps = source().get(cv::CAP_PROP_FPS);
+        if (out_fps <= 0) out_fps = 25.0;
+        VideoOverlay overlay;
+        if (use_video) overlay.source = fs::path(video_files[0]).filename().string();
+        if (m_video_out) m_video_out->set_overlay(overlay);
 
         // WINDOW_AUTOSIZE: ウィンドウサイズ = 画像サイズ (比率は絶対に崩れない)
         // サイズは --scale で制御 (例: --scale 0.5 で半分)
-        cv::namedWindow("Video", cv::WINDOW_AUTOSIZE);
-        cv::namedWindow("Frame", cv::WINDOW_AUTOSIZE);
+        // ソーク時はウィンドウを作らず、対話モードも無効 (無人運転)
+        if (!m_headless) {
+            cv::namedWindow("Video", cv::WINDOW_AUTOSIZE);
+            cv::namedWindow("Frame", cv::WINDOW_AUTOSIZE);
+        }
 
-        banner(use_video ? "VIDEO STARTED  |  ENTER=ask  q=quit"
-                         : "CAMERA STARTED  |  ENTER=ask  q=quit");
+        std::optional<SoakMonitor> soak;
+        if (m_soak_cfg.enabled()) {
+            soak.emplace(m_soak_cfg);
+            std::ostringstream o;
+            o << "SOAK TEST  |  " << m_soak_cfg.duration_min << " min  |  Ctrl+C=stop";
+            banner(o.str());
+        } else {
+            banner(use_video ? "VIDEO STARTED  |  ENTER=ask  q=quit"
+                             : "CAMERA STARTED  |  ENTER=ask  q=quit");
+        }
 
         enum class Mode { MONITORING, WAIT_Q, PROC_VLM, WAIT_CONT };
         Mode mode = Mode::MONITORING;
         cv::Mat frozen;
         std::future<InferenceResult> vlm_fut;
+        std::future<std::vector<InferenceResult>> batch_fut;
+        std::vector<std::string> batch_questions;
+        // Worker が応答しなくなっても対話を抜けられるよう、回答待ちにも期限を設ける
+        std::chrono::steady_clock::time_point answer_deadline;
+
+        // ';' 区切りの複数質問は 1 回の生成にまとめる (image が空 = 追加質問)
+        auto ask = [&](const cv::Mat& image, const std::string& q) {
+            auto qs = split_questions(q);
+            log_info("") << "Processing...";
+            if (qs.size() > 1) {
+                batch_questions = qs;
+                batch_fut = m_backend.submit_batch_questions(image, qs, /*session=*/true);
+            } else {
+                vlm_fut = m_backend.submit_session_question(image, q);
+            }
+            // まとめて 1 回 + 個別の問い合わせ (1 回あたり最大 60 秒)
+            answer_deadline = std::chrono::steady_clock::now() +
+                std::chrono::seconds(60) * (qs.size() > 1 ? qs.size() + 1 : 1);
+            mode = Mode::PROC_VLM;
+        };
+        auto last_aggregate = std::chrono::steady_clock::now();
         std::string pending_video_msg;
+        std::string last_category;
+        std::vector<std::string> last_view_category;
 
-        while (cap.isOpened() && g_running) {
+        while ((playlist || camera->isOpened()) && g_running) {
             cv::Mat frame;
-            if (!cap.read(frame) || frame.empty()) {
-                if (use_video) {
-                    // 次の動画 (末尾なら先頭に戻る)
-                    video_idx = (video_idx + 1) % video_files.size();
-                    cap.open(video_files[video_idx]);
-                    if (cap.isOpened()) {
-                        pending_video_msg = format_video_info(cap, video_files[video_idx]);
-                        wait_ms = calc_wait_ms(cap, true);
-                    }
-                    continue;
-                }
-                break;
+            bool got = false, switched = false;
+            {
+                VLM_TRACE_SCOPE("capture");
+                // 動画は末尾で先読み済みの次のファイルに切り替わる (末尾なら先頭に戻る)
+                got = playlist ? playlist->read(frame, switched)
+                               : camera->read(frame) && !frame.empty();
+            }
+            if (!got) break;
+            if (switched) {
+                pending_video_msg = format_video_info(playlist->capture(), playlist->path());
+                wait_ms = calc_wait_ms(playlist->capture(), true);
+                overlay.source = fs::path(playlist->path()).filename().string();
+                if (m_video_out) m_video_out->set_overlay(overlay);
             }
 
-            cv::imshow("Video", scale_for_display(frame, m_scale));
+            // イベント前バッファ (間引き + エンコードは録画スレッド)
+            if (m_clips) m_clips->push(frame);
+            // 注釈付き出力動画 (描画/エンコードは専用スレッド)
+            if (m_video_out) m_video_out->push(frame, out_fps);
 
-            int key = cv::waitKey(wait_ms) & 0xFF;
+            int key = 0;
+            {
+                VLM_TRACE_SCOPE("display");
+                show("Video", frame);
+                if (m_headless) std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+                else key = cv::waitKey(wait_ms) & 0xFF;
+            }
             if (key == 'q' || key == 'Q') {
-                std::cout << "\n'q' pressed - shutting down..." << std::endl;
+                log_info("") << "\n'q' pressed - shutting down...";
                 g_running = false;
                 break;
             }
+            if ((key == 't' || key == 'T') && !m_trace_path.empty()) dump_trace();
+            if (key == 'a' || key == 'A') print_aggregates(true);
+            if (m_aggregate_interval_s > 0 &&
+                std::chrono::steady_clock::now() - last_aggregate >= std::chrono::seconds(m_aggregate_interval_s))
+            {
+                last_aggregate = std::chrono::steady_clock::now();
+                print_aggregates(false);
+            }
 
             switch (mode) {
             case Mode::MONITORING: {
                 // バッファしていた動画切り替えメッセージを出力
                 if (!pending_video_msg.empty()) {
-                    std::cout << pending_video_msg << std::endl;
+                    log_info("") << pending_video_msg;
                     pending_video_msg.clear();
                 }
                 // 推論には原寸フレームを渡す
@@ -221,53 +326,123 @@ public:
 
                 MonitoringResult mr;
                 if (m_backend.poll_result(mr)) {
-                    cv::imshow("Frame", scale_for_display(mr.frame, m_scale));
+                    // 前景領域 (背景モデル有効時。モザイクは座標が合わないので描かない)
+                    if (mr.views.empty() && !mr.frame.empty())
+                        for (const auto& b : mr.foreground.boxes)
+                            cv::rectangle(mr.frame, b, cv::Scalar(0, 200, 255), 2);
+                    show("Frame", mr.frame);
                     std::string tag = "[OK]";
                     if (mr.result.answer.find("rror") != std::string::npos ||
                         mr.result.answer.find("bort") != std::string::npos)
                         tag = "[WARN]";
                     else if (mr.result.answer.find("No Event Detected") == std::string::npos)
                         tag = "[INFO]";
-                    std::cout << "[" << now_str() << "] " << tag << " "
-                              << mr.result.answer << " | " << mr.result.time_str
-                              << std::endl;
+                    log_info("") << "[" << now_str() << "] " << tag << " "
+                                 << mr.result.answer << " | " << mr.result.time_str;
+                    // 状態遷移 (例: empty → pickup) でクリップを録画
+                    // モザイク時はビューごとに遷移を判定する
+                    if (!mr.views.empty()) {
+                        last_view_category.resize(mr.views.size());
+                        for (size_t i = 0; i < mr.views.size(); i++) {
+                            const auto& cat = mr.views[i].category;
+                            auto& last = last_view_category[i];
+                            if (cat == "unknown") continue;
+                            if (!last.empty() && cat != last) {
+                                log_info("") << "    view " << (i + 1) << ": " << last << " -> " << cat;
+                                if (m_clips)
+                                    m_clips->trigger("view" + std::to_string(i + 1) + "_" + last + "_to_" + cat);
+                            }
+                            last = cat;
+                        }
+                    } else if (!mr.result.error && !mr.result.category.empty()) {
+                        if (m_clips && !last_category.empty() &&
+                            mr.result.category != last_category)
+                            m_clips->trigger(last_category + "_to_" + mr.result.category);
+                        last_category = mr.result.category;
+                    }
+                    if (m_video_out) {
+                        overlay.category = mr.result.category.empty() ? mr.result.answer
+                                                                       : mr.result.category;
+                        auto raw = mr.result.answer.find("[raw: ");
+                        overlay.raw = (raw != std::string::npos) ? mr.result.answer.substr(raw) : "";
+                        overlay.latency = mr.result.time_str;
+                        m_video_out->set_overlay(overlay);
+                    }
+                    if (soak) {
+                        soak->record_cycle(mr.result.seconds, mr.result.error, mr.result.injected,
+                                           m_backend.stats().generator_recreates);
+                        if (soak->report_due()) log_info("") << soak->report();
+                    }
+                }
+                if (soak) {
+                    if (soak->finished()) g_running = false;
+                    break;
                 }
                 if (check_enter()) {
                     m_backend.pause_monitoring();
                     m_backend.abort_current();
                     frozen = frame.clone();
-                    cv::imshow("Frame", scale_for_display(frozen, m_scale));
+                    show("Frame", frozen);
                     mode = Mode::WAIT_Q;
-                    std::cout << "\n\nQuestion (Enter='Describe the image'): " << std::flush;
+                    log_raw("\n\nQuestion (Enter='Describe the image'): ");
+                    log_flush();   // プロンプトを表示してから標準入力を読む
                 }
                 break;
             }
             case Mode::WAIT_Q: {
                 std::string q = read_line();
-                if (q.empty()) { q = "Describe the image"; std::cout << "=> " << q << std::endl; }
+                if (q.empty()) { q = "Describe the image"; log_info("") << "=> " << q; }
                 if (!m_backend.is_ready()) {
-                    std::cout << "[ERROR] Device not ready.\nPress Enter..." << std::endl;
+                    log_info("") << "[ERROR] Device not ready.\nPress Enter...";
                     mode = Mode::WAIT_CONT;
                 } else {
-                    std::cout << "Processing..." << std::endl;
-                    auto fc = frozen.clone();
-                    vlm_fut = std::async(std::launch::async,
-                        [this, fc, q]() { return m_backend.vlm_custom_inference(fc, q); });
-                    mode = Mode::PROC_VLM;
+                    // 対話セッションを開始 (追加質問は画像を再送しない)
+                    ask(frozen, q);
                 }
                 break;
             }
             case Mode::PROC_VLM: {
-                if (vlm_fut.valid() &&
-                    vlm_fut.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
+                auto ready = [](auto& f) {
+                    return f.valid() &&
+                           f.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready;
+                };
+                bool done = false;
+                if (ready(vlm_fut)) {
                     try { vlm_fut.get(); } catch (...) {}
+                    done = true;
+                } else if (ready(batch_fut)) {
+                    try {
+                        auto rs = batch_fut.get();
+                        std::ostringstream o;
+                        for (size_t i = 0; i < rs.size() && i < batch_questions.size(); i++)
+                            o << "\n  Q" << (i + 1) << ": " << batch_questions[i]
+                              << "\n  A" << (i + 1) << ": " << rs[i].answer
+                              << "  (" << rs[i].time_str << ")";
+                        log_info("") << "\n" << o.str();
+                    } catch (...) {}
+                    done = true;
+                } else if (std::chrono::steady_clock::now() >= answer_deadline) {
+                    log_warn("") << "No answer from the VLM - giving up.";
+                    m_backend.abort_current();
+                    vlm_fut = {};
+                    batch_fut = {};
+                    done = true;
+                }
+                if (done) {
                     mode = Mode::WAIT_CONT;
-                    std::cout << "\n\nPress Enter to continue..." << std::endl;
+                    log_raw("\n\nFollow-up question (Enter=resume monitoring): ");
+                    log_flush();
                 }
                 break;
             }
             case Mode::WAIT_CONT: {
-                if (check_enter()) {
+                std::string q;
+                if (!poll_line(q)) break;
+                if (!q.empty() && m_backend.is_ready()) {
+                    // 同じフレームへの追加質問 (コンテキストを引き継ぐ)
+                    ask(cv::Mat(), q);
+                } else {
+                    m_backend.end_session();
                     m_backend.resume_monitoring();
                     mode = Mode::MONITORING;
                     banner("RESUMED  |  ENTER=ask  q=quit");
@@ -277,18 +452,192 @@ public:
             }
         }
 
-        std::cout << "Shutting down..." << std::endl;
+        log_info("") << "Shutting down...";
+        if (m_clips) m_clips->close();   // 録画中のクリップを書き出してから停止
         m_backend.abort_current();
         m_backend.close();
-        cap.release();
-        cv::destroyAllWindows();
+        if (m_video_out) m_video_out->close();
+        if (auto* v = dynamic_cast<V4L2Capture*>(camera.get()))
+            log_info("V4L2") << v->stale_dropped() << " stale frames skipped";
+        if (camera) camera->release();
+        if (playlist)
+            log_info("Playlist") << playlist->switches() << " switches, "
+                                 << playlist->inline_opens() << " opened without prefetch";
+        if (!m_headless) cv::destroyAllWindows();
+        print_stats();
+        print_aggregates(false);
+        if (!m_trace_path.empty()) dump_trace();
+
+        if (soak) {
+            std::string summary;
+            bool ok = soak->passed(summary);
+            log_info("") << summary;
+            return ok ? 0 : 2;
+        }
+        return 0;
     }
 
 private:
+    // =========================================================================
+    //  フォルダー監視取り込み: 1 枚ずつ監視パスに通し、結果を画像の隣に書く
+    //  (次の画像は前の結果が出てから渡すので、結果と画像が必ず対応する)
+    // =========================================================================
+    int run_watch() {
+        FolderWatcher watcher(m_watch_cfg, m_backend.executor());
+        if (!watcher.start()) return 1;
+        banner("WATCHING " + m_watch_cfg.dir + "  |  Ctrl+C=stop");
+        const QualityConfig& quality = m_watch_cfg.quality;
+        // 1 枚の結果を待つ上限 (スケジュール停止中は数えない)
+        const auto result_timeout = std::chrono::seconds(120);
+
+        uint64_t processed = 0;
+        auto last_aggregate = std::chrono::steady_clock::now();
+        while (g_running) {
+            if (m_aggregate_interval_s > 0 &&
+                std::chrono::steady_clock::now() - last_aggregate >= std::chrono::seconds(m_aggregate_interval_s))
+            {
+                last_aggregate = std::chrono::steady_clock::now();
+                print_aggregates(false);
+            }
+
+            WatchItem item;
+            if (!watcher.next(item, std::chrono::milliseconds(200))) continue;
+            const std::string name = fs::path(item.path).filename().string();
+            json out = {{"image", name}, {"use_case", m_backend.use_case()}};
+            std::string summary;
+
+            if (!item.error.empty()) {
+                out["error"] = true;
+                out["answer"] = "Decode failed: " + item.error;
+                summary = "[WARN] " + out["answer"].get<std::string>();
+            } else {
+                out["width"] = item.image.cols;
+                out["height"] = item.image.rows;
+                // 除外理由を画像ごとに記録するため、watch では品質ゲートをここで判定する
+                // (Backend 側の判定は無効にしてある)
+                auto verdict = quality.enabled
+                    ? judge_frame_quality(measure_frame_quality(item.image, quality.analysis_width), quality)
+                    : QualityVerdict::Ok;
+                if (verdict != QualityVerdict::Ok) {
+                    out["skipped"] = quality_verdict_name(verdict);
+                    summary = std::string("[SKIP] ") + quality_verdict_name(verdict);
+                } else {
+                    // 期限切れで諦めた前の画像の結果が後から届いていれば捨てる
+                    MonitoringResult mr;
+                    m_backend.poll_result(mr);
+                    m_backend.update_frame(item.image);
+                    // モデル読み込み中・スケジュール停止中は期限を延ばして待つ
+                    bool have = false;
+                    auto deadline = std::chrono::steady_clock::now() + result_timeout;
+                    while (g_running && m_backend.is_alive() && !(have = m_backend.poll_result(mr))) {
+                        auto now = std::chrono::steady_clock::now();
+                        if (!m_backend.is_ready() || m_backend.schedule_paused())
+                            deadline = now + result_timeout;
+                        else if (now >= deadline)
+                            break;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    }
+                    if (!have && (!g_running || !m_backend.is_alive())) {
+                        // 結果を書かずに終了 (次回起動時に再処理)
+                        if (g_running) log_error("Watch") << "Backend stopped - leaving " << name << " for a rescan.";
+                        break;
+                    }
+                    if (!have) {
+                        // 結果が出なかった (推論が固まった / Backend がフレームを捨てた)
+                        m_backend.abort_current();
+                        mr.result.error = true;
+                        mr.result.answer = "No result within " + std::to_string(result_timeout.count()) + " s";
+                        mr.result.time_str = "N/A";
+                    }
+                    out["category"] = mr.result.category;
+                    out["answer"] = mr.result.answer;
+                    out["latency"] = mr.result.seconds;
+                    out["error"] = mr.result.error;
+                    if (!mr.views.empty()) {
+                        out["views"] = json::array();
+                        for (const auto& v : mr.views) out["views"].push_back(v.category);
+                    }
+                    summary = (mr.result.error ? "[WARN] " : "[OK] ") + mr.result.answer
+                              + " | " + mr.result.time_str;
+                }
+            }
+            out["ts"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            if (!write_watch_result(item.path, out))
+                log_error("Watch") << "Cannot write " << item.path << ".json";
+            watcher.done(item.path);
+            processed++;
+            log_info("") << "[" << now_str() << "] " << name << ": " << summary
+                         << "  (backlog " << watcher.backlog() << ")";
+        }
+
+        log_info("") << "Shutting down...";
+        watcher.close();
+        m_backend.abort_current();
+        m_backend.close();
+        log_info("Watch") << processed << " images processed, " << watcher.detected()
+                          << " detected, " << watcher.deferred() << " deferred by full backlog";
+        print_stats();
+        print_aggregates(false);
+        if (!m_trace_path.empty()) dump_trace();
+        return 0;
+    }
+
+    void dump_trace() {
+        if (trace::dump(m_trace_path))
+            log_info("") << "Trace written: " << m_trace_path;
+        else
+            log_error("") << "Cannot write trace: " << m_trace_path;
+    }
+
+    void show(const std::string& win, const cv::Mat& frame) {
+        if (!m_headless) cv::imshow(win, scale_for_display(frame, m_scale));
+    }
+
+    void print_stats() {
+        auto st = m_backend.stats();
+        std::ostringstream o;
+        o << std::fixed << std::setprecision(1)
+          << "Stats: inferences=" << st.inferences
+          << "  telemetry=" << st.telemetry_source;
+        if (st.temperature_c) o << "  temp=" << *st.temperature_c << "C";
+        if (st.power_w) o << "  power=" << *st.power_w << "W";
+        o << "  errors=" << st.errors
+          << "  recreates=" << st.generator_recreates
+          << "  duty=" << (st.duty_cycle * 100.0) << "%"
+          << "  throttle_events=" << st.throttle_events
+          << "  throttled=" << st.throttled_sec << "s";
+        if (m_clips) o << "  clips=" << m_clips->clips_written();
+        if (st.skipped_dark + st.skipped_overexposed + st.skipped_low_contrast + st.skipped_blurred)
+            o << "  skipped(dark/bright/flat/blur)=" << st.skipped_dark << "/"
+              << st.skipped_overexposed << "/" << st.skipped_low_contrast << "/"
+              << st.skipped_blurred;
+        if (!st.schedule.empty()) o << "  schedule=" << st.schedule;
+        if (st.prefilter_negatives + st.prefilter_escalations)
+            o << "  prefilter(neg/vlm)=" << st.prefilter_negatives << "/" << st.prefilter_escalations;
+        if (st.published + st.publish_dropped)
+            o << "  published=" << st.published << " (dropped " << st.publish_dropped << ")";
+        log_info("") << o.str();
+
+        std::ostringstream t;
+        t << std::fixed << std::setprecision(2) << "Thread CPU:";
+        for (const auto& [name, sec] : st.thread_cpu_sec) t << "  " << name << "=" << sec << "s";
+        log_info("") << t.str();
+    }
+
+    // 直近 1 分 / 1 時間 / 1 日の割合 (table=true なら直近 1 日の時間別件数も)
+    void print_aggregates(bool table) {
+        for (auto span : {AggregateSpan::Minute, AggregateSpan::Hour, AggregateSpan::Day}) {
+            auto r = m_backend.aggregates(span);
+            log_info("Aggregate") << r.use_case << " last " << aggregate_span_name(span) << ": "
+                                  << format_aggregate_summary(r);
+        }
+        if (table) log_raw(format_aggregate_table(m_backend.aggregates(AggregateSpan::Day)));
+    }
+
     void banner(const std::string& s) {
-        std::cout << "\n" << std::string(80, '=')
-                  << "\n  " << s
-                  << "\n" << std::string(80, '=') << "\n" << std::endl;
+        log_raw("\n" + std::string(80, '=') + "\n  " + s +
+                "\n" + std::string(80, '=') + "\n\n");
     }
 
     std::string format_video_info(const cv::VideoCapture& c, const std::string& name) {
@@ -310,6 +659,15 @@ private:
     int m_cam_id;
     std::string m_video_path;
     double m_scale;
+    SoakConfig m_soak_cfg;
+    bool m_headless;
+    ThreadPolicy m_capture_policy;
+    std::string m_trace_path;
+    int m_aggregate_interval_s;
+    WatchConfig m_watch_cfg;
+    CameraConfig m_camera_cfg;
+    std::unique_ptr<ClipRecorder> m_clips;   // m_backend より先に破棄
+    std::unique_ptr<AnnotatedVideoWriter> m_video_out;
 };
 
 // =============================================================================
@@ -318,6 +676,22 @@ struct Args {
     int camera = 0, cooldown = 1000;
     double scale = 1.0;
     bool diagnose = false;
+    bool list_cameras = false;
+    BackendOptions backend;
+    SoakConfig soak;
+    ThreadPolicy capture_policy;
+    std::string trace;
+    size_t trace_events = 65536;
+    LogLevel log_level = LogLevel::Info;
+    bool log_json = false;
+    size_t log_queue = 4096;
+    ClipConfig clip;
+    std::string output_video;
+    size_t output_queue = 32;
+    int aggregate_interval = 0;
+    ProfileConfig profile;
+    WatchConfig watch;
+    CameraConfig camera_cfg;
 };
 
 static Args parse(int argc, char* argv[]) {
@@ -330,52 +704,291 @@ static Args parse(int argc, char* argv[]) {
         else if ((s == "--hef" || s == "-m") && i+1 < argc) a.hef = argv[++i];
         else if (s == "--cooldown" && i+1 < argc) a.cooldown = std::stoi(argv[++i]);
         else if (s == "--scale" && i+1 < argc) a.scale = std::stod(argv[++i]);
+        else if (s == "--thermal-limit" && i+1 < argc) a.backend.thermal.limit_c = std::stof(argv[++i]);
+        else if (s == "--thermal-start" && i+1 < argc) a.backend.thermal.throttle_start_c = std::stof(argv[++i]);
+        else if (s == "--thermal-hysteresis" && i+1 < argc) a.backend.thermal.hysteresis_c = std::stof(argv[++i]);
+        else if (s == "--max-slowdown" && i+1 < argc) a.backend.thermal.max_slowdown = std::stod(argv[++i]);
+        else if (s == "--max-duty" && i+1 < argc) a.backend.thermal.max_duty = std::stod(argv[++i]);
+        else if (s == "--telemetry-interval" && i+1 < argc) a.backend.thermal.sample_interval_ms = std::stoi(argv[++i]);
+        else if (s == "--telemetry-sim") a.backend.thermal.simulate = true;
+        else if (s == "--soak" && i+1 < argc) a.soak.duration_min = std::stod(argv[++i]);
+        else if (s == "--soak-report" && i+1 < argc) a.soak.report_interval_s = std::stoi(argv[++i]);
+        else if (s == "--soak-max-drift" && i+1 < argc) a.soak.max_latency_drift = std::stod(argv[++i]);
+        else if (s == "--soak-max-rss" && i+1 < argc) a.soak.max_rss_growth_mb = std::stod(argv[++i]);
+        else if (s == "--soak-max-handles" && i+1 < argc) a.soak.max_handle_growth = std::stoi(argv[++i]);
+        else if (s == "--soak-max-recreates" && i+1 < argc) a.soak.max_recreates = std::stoull(argv[++i]);
+        else if (s == "--soak-max-error-rate" && i+1 < argc) a.soak.max_error_rate = std::stod(argv[++i]);
+        else if (s == "--fault-rate" && i+1 < argc) a.backend.fault_rate = std::stod(argv[++i]);
+        else if (s == "--pool-threads" && i+1 < argc) a.backend.pool_threads = std::stoul(argv[++i]);
+        else if (s == "--pool-cores" && i+1 < argc) a.backend.pool_policy.cores = parse_core_list(argv[++i]);
+        else if (s == "--thread-policy" && i+1 < argc) {
+            // <role>=<cores>[/fifo:<prio>|/nice:<n>]
+            std::string v = argv[++i];
+            auto eq = v.find('=');
+            std::string role = v.substr(0, eq);
+            ThreadPolicy tp;
+            std::string err;
+            if (!parse_thread_policy(eq == std::string::npos ? "" : v.substr(eq + 1), tp, err)) {
+                log_error("") << "Bad thread policy " << v << ": " << err; std::exit(1);
+            }
+            if (role == "capture")        a.capture_policy = tp;
+            else if (role == "worker")    a.backend.worker_policy = tp;
+            else if (role == "pool")      a.backend.pool_policy = tp;
+            else if (role == "telemetry") a.backend.telemetry_policy = tp;
+            else { log_error("") << "Unknown thread role: " << role; std::exit(1); }
+        }
+        else if (s == "--trace" && i+1 < argc) a.trace = argv[++i];
+        else if (s == "--trace-events" && i+1 < argc) a.trace_events = std::stoul(argv[++i]);
+        else if (s == "--log-level" && i+1 < argc) {
+            if (!parse_log_level(argv[++i], a.log_level)) {
+                log_error("") << "Unknown log level: " << argv[i]; std::exit(1);
+            }
+        }
+        else if (s == "--log-json") a.log_json = true;
+        else if (s == "--log-queue" && i+1 < argc) a.log_queue = std::stoul(argv[++i]);
+        else if (s == "--multi-frame" && i+1 < argc) a.backend.multi_frames = std::stoi(argv[++i]);
+        else if (s == "--multi-frame-window" && i+1 < argc) a.backend.multi_frame_window_sec = std::stod(argv[++i]);
+        else if (s == "--session-tokens" && i+1 < argc) a.backend.session_token_budget = std::stoul(argv[++i]);
+        else if (s == "--mosaic" && i+1 < argc) {
+            if (!parse_mosaic_layout(argv[++i], a.backend.mosaic_rois)) {
+                log_error("") << "Bad mosaic layout: " << argv[i]
+                              << " (grid:<cols>x<rows> or x,y,w,h;x,y,w,h;...)";
+                std::exit(1);
+            }
+        }
+        else if (s == "--frame-select" && i+1 < argc) {
+            std::string v = argv[++i];
+            if (v == "latest") a.backend.frame_select = FrameSelect::Latest;
+            else if (v == "foreground") a.backend.frame_select = FrameSelect::Foreground;
+            else if (v == "best") a.backend.frame_select = FrameSelect::Best;
+            else { log_error("") << "Unknown frame selection: " << v << " (latest|foreground|best)"; std::exit(1); }
+        }
+        else if (s == "--frame-weights" && i+1 < argc) {
+            auto& w = a.backend.frame_score;
+            if (std::sscanf(argv[++i], "%lf,%lf,%lf", &w.sharpness, &w.foreground, &w.change) != 3) {
+                log_error("") << "Bad frame weights: " << argv[i] << " (sharpness,foreground,change)";
+                std::exit(1);
+            }
+        }
+        else if (s == "--schedule" && i+1 < argc) {
+            // ルールの配列、または {"schedule": [...]} の JSON ファイル
+            std::ifstream f(argv[++i]);
+            json j;
+            std::string err;
+            try { if (f.is_open()) f >> j; }
+            catch (const json::parse_error& e) { err = e.what(); }
+            if (j.is_object() && j.contains("schedule")) j = j["schedule"];
+            if (!f.is_open()) err = "cannot open";
+            if (err.empty()) a.backend.schedule.parse(j, err);
+            if (!err.empty()) {
+                log_error("") << "Bad schedule " << argv[i] << ": " << err; std::exit(1);
+            }
+        }
+        else if (s == "--aggregate-interval" && i+1 < argc) a.aggregate_interval = std::stoi(argv[++i]);
+        else if (s == "--watch" && i+1 < argc) a.watch.dir = argv[++i];
+        else if (s == "--watch-backlog" && i+1 < argc) a.watch.max_backlog = (size_t)std::max(1, std::stoi(argv[++i]));
+        else if (s == "--watch-decode-ahead" && i+1 < argc) a.watch.decode_ahead = (size_t)std::max(1, std::stoi(argv[++i]));
+        else if (s == "--watch-max-side" && i+1 < argc) a.watch.max_side = std::max(0, std::stoi(argv[++i]));
+        else if (s == "--watch-poll" && i+1 < argc) a.watch.poll_ms = std::max(0, std::stoi(argv[++i]));
+        else if (s == "--publish" && i+1 < argc) a.backend.publish.path = argv[++i];
+        else if (s == "--publish-queue" && i+1 < argc) a.backend.publish.queue_limit = (size_t)std::max(1, std::stoi(argv[++i]));
+        else if (s == "--publish-batch-ms" && i+1 < argc) a.backend.publish.batch_ms = std::max(0, std::stoi(argv[++i]));
+        else if (s == "--publish-drop" && i+1 < argc) {
+            if (!parse_drop_policy(argv[++i], a.backend.publish.drop)) {
+                log_error("") << "Bad drop policy: " << argv[i] << " (oldest|newest|disconnect)";
+                std::exit(1);
+            }
+        }
+        else if (s == "--quality-gate") a.backend.quality.enabled = true;
+        else if (s == "--min-luma" && i+1 < argc) { a.backend.quality.min_luma = std::stod(argv[++i]); a.backend.quality.enabled = true; }
+        else if (s == "--max-luma" && i+1 < argc) { a.backend.quality.max_luma = std::stod(argv[++i]); a.backend.quality.enabled = true; }
+        else if (s == "--min-contrast" && i+1 < argc) { a.backend.quality.min_contrast = std::stod(argv[++i]); a.backend.quality.enabled = true; }
+        else if (s == "--min-sharpness" && i+1 < argc) { a.backend.quality.min_sharpness = std::stod(argv[++i]); a.backend.quality.enabled = true; }
+        else if (s == "--clip-dir" && i+1 < argc) a.clip.dir = argv[++i];
+        else if (s == "--clip-pre" && i+1 < argc) a.clip.pre_sec = std::stod(argv[++i]);
+        else if (s == "--clip-post" && i+1 < argc) a.clip.post_sec = std::stod(argv[++i]);
+        else if (s == "--clip-fps" && i+1 < argc) a.clip.fps = std::stod(argv[++i]);
+        else if (s == "--clip-max-mb" && i+1 < argc) a.clip.max_disk_mb = std::stod(argv[++i]);
+        else if (s == "--clip-max-len" && i+1 < argc) a.clip.max_sec = std::stod(argv[++i]);
+        else if ((s == "--output-video" || s == "-o") && i+1 < argc) a.output_video = argv[++i];
+        else if (s == "--output-queue" && i+1 < argc) a.output_queue = std::stoul(argv[++i]);
+        else if (s == "--profile" && i+1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string f;
+            while (std::getline(ss, f, ','))
+                if (!f.empty()) a.profile.prompt_files.push_back(f);
+        }
+        else if (s == "--profile-runs" && i+1 < argc) a.profile.runs = std::stoi(argv[++i]);
+        else if (s == "--profile-image" && i+1 < argc) a.profile.image = argv[++i];
         else if (s == "--diagnose" || s == "-d") a.diagnose = true;
+        else if (s == "--list-cameras") a.list_cameras = true;
+        else if (s == "--camera-size" && i+1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &a.camera_cfg.width, &a.camera_cfg.height) != 2) {
+                log_error("") << "Bad camera size: " << argv[i] << " (WxH)"; std::exit(1);
+            }
+        }
+        else if (s == "--camera-fps" && i+1 < argc) a.camera_cfg.fps = std::stoi(argv[++i]);
+        else if (s == "--v4l2") a.camera_cfg.v4l2 = true;
+        else if (s == "--v4l2-format" && i+1 < argc) {
+            a.camera_cfg.v4l2_cfg.format = argv[++i];
+            a.camera_cfg.v4l2 = true;
+            const auto& f = a.camera_cfg.v4l2_cfg.format;
+            if (f != "auto" && f != "yuyv" && f != "mjpeg") {
+                log_error("") << "Bad V4L2 format: " << f << " (auto|yuyv|mjpeg)"; std::exit(1);
+            }
+        }
+        else if (s == "--v4l2-buffers" && i+1 < argc) { a.camera_cfg.v4l2_cfg.buffers = std::max(1, std::stoi(argv[++i])); a.camera_cfg.v4l2 = true; }
         else if (s == "--help" || s == "-h") {
-            std::cout << "Usage: " << argv[0] << "\n"
+            log_raw(std::string("Usage: ") + argv[0] + "\n"
                 "  --prompts, -p <path>   Prompts JSON\n"
                 "  --camera,  -c <id>     Camera (0)\n"
                 "  --video,   -v <path>   Video file or folder of videos\n"
                 "  --hef,     -m <path>   HEF model\n"
                 "  --scale <factor>       Display scale (0.5=half, default: 1.0)\n"
                 "  --cooldown <ms>        Pause between inferences (1000)\n"
-                "  --diagnose, -d         Device diagnostics\n";
+                "  --thermal-limit <C>    Thermal budget; cooldown is stretched up to it (off)\n"
+                "  --thermal-start <C>    Temperature where throttling starts (limit - 10)\n"
+                "  --thermal-hysteresis <C>  Throttling ends this far below the start (3)\n"
+                "  --max-slowdown <x>     Cooldown multiplier at the thermal limit (8)\n"
+                "  --max-duty <0..1>      Max fraction of time spent inferring (1.0)\n"
+                "  --telemetry-interval <ms>  Telemetry sampling period (2000)\n"
+                "  --telemetry-sim        Use simulated thermal model instead of device\n"
+                "  --soak <minutes>       Headless soak test; exit code 2 on drift\n"
+                "  --soak-report <s>      Soak progress report interval (60)\n"
+                "  --soak-max-drift <r>   Max latency drift ratio (0.25)\n"
+                "  --soak-max-rss <MB>    Max RSS growth (64)\n"
+                "  --soak-max-handles <n> Max open handle growth (16)\n"
+                "  --soak-max-recreates <n>  Max generator recreates (100)\n"
+                "  --soak-max-error-rate <r>  Max error rate, excluding --fault-rate faults (0.05)\n"
+                "  --fault-rate <p>       Inject monitor errors with probability p (0)\n"
+                "  --pool-threads <n>     Shared executor threads (2)\n"
+                "  --pool-cores <list>    Pin executor threads to cores, e.g. 2-3\n"
+                "  --thread-policy <role>=<cores>[/fifo:<p>|/nice:<n>]\n"
+                "                         role: capture|worker|pool|telemetry (repeatable)\n"
+                "  --trace <file>         Write Chrome trace JSON at exit ('t' dumps now)\n"
+                "  --trace-events <n>     Trace ring buffer size per thread (65536)\n"
+                "  --log-level <level>    debug|info|warn|error (info)\n"
+                "  --log-json             Structured JSON log lines\n"
+                "  --log-queue <n>        Async log queue capacity (4096)\n"
+                "  --multi-frame <k>      Frames per monitor inference, oldest first (1)\n"
+                "  --multi-frame-window <s>  Time span covered by those frames (2.0)\n"
+                "  --session-tokens <n>   Context budget for follow-up questions (3/4 of capacity)\n"
+                "  --mosaic <layout>      Tile views into one input: grid:2x2 or x,y,w,h;...\n"
+                "  --frame-select <mode>  Frame sent per cycle: latest|foreground|best (latest)\n"
+                "  --frame-weights <s,f,c>  Best-frame weights: sharpness,foreground,change (1,1,1)\n"
+                "  --schedule <json>      Monitoring schedule for this stream (overrides prompt file)\n"
+                "  --aggregate-interval <s>  Log category shares for the last minute/hour/day (off)\n"
+                "  --watch <dir>          Classify JPEG/PNG files dropped into <dir>, write <image>.json\n"
+                "  --watch-backlog <n>    Max images queued; the rest are rescanned later (256)\n"
+                "  --watch-decode-ahead <n>  Images decoded in parallel ahead of the VLM (4)\n"
+                "  --watch-max-side <px>  Decode at reduced size keeping this long side, 0=full (1280)\n"
+                "  --watch-poll <ms>      Poll instead of inotify, e.g. network shares (Windows: 1000)\n"
+                "  --publish <path>       Stream results as JSON lines on a Unix socket (off)\n"
+                "  --publish-queue <n>    Messages buffered per subscriber (256)\n"
+                "  --publish-batch-ms <ms>  Coalesce messages written within this interval (100)\n"
+                "  --publish-drop <p>     Full queue: oldest|newest|disconnect (oldest)\n"
+                "  --quality-gate         Skip dark, overexposed, flat or blurred frames (off)\n"
+                "  --min-luma <v>         Quality gate: min mean luminance 0-255 (20)\n"
+                "  --max-luma <v>         Quality gate: max mean luminance (235)\n"
+                "  --min-contrast <v>     Quality gate: min luminance std-dev (10)\n"
+                "  --min-sharpness <v>    Quality gate: min Laplacian variance at 160px (30)\n"
+                "  --clip-dir <dir>       Record clips around monitor state changes (off)\n"
+                "  --clip-pre <s>         Seconds kept before the event (5)\n"
+                "  --clip-post <s>        Seconds recorded after the event (5)\n"
+                "  --clip-fps <fps>       Clip frame rate (5)\n"
+                "  --clip-max-mb <MB>     Disk budget; oldest clips are deleted (1024)\n"
+                "  --clip-max-len <s>     Longest single clip; continues in a new file (60, 0=no limit)\n"
+                "  --output-video, -o <path>  Write annotated video (.avi=MJPG, else mp4v)\n"
+                "  --output-queue <n>     Output video queue; frames beyond it are dropped (32)\n"
+                "  --profile <json>[,...] Measure prompt tokens/latency per use case and exit\n"
+                "                         (repeatable; compare prompt variants side by side)\n"
+                "  --profile-runs <n>     Measured runs per use case, median reported (3)\n"
+                "  --profile-image <path> Image used for profiling (gray frame)\n"
+                "  --camera-size <WxH>    Camera resolution (640x480)\n"
+                "  --camera-fps <n>       Camera frame rate (30)\n"
+                "  --v4l2                 Capture with V4L2 mmap buffers instead of OpenCV (Linux)\n"
+                "  --v4l2-format <f>      auto|yuyv|mjpeg; auto = YUYV if it reaches size/fps (auto)\n"
+                "  --v4l2-buffers <n>     Driver buffer count; fewer = lower latency (2)\n"
+                "  --list-cameras         List V4L2 capture devices and exit (Linux)\n"
+                "  --diagnose, -d         Device diagnostics\n");
             std::exit(0);
         }
     }
-    if (!a.diagnose && a.prompts.empty()) {
-        std::cerr << "Error: --prompts required." << std::endl; std::exit(1);
+    auto& th = a.backend.thermal;
+    if (th.enabled() && th.throttle_start_c <= 0.0f)
+        th.throttle_start_c = th.limit_c - 10.0f;
+    a.profile.hef = a.hef;
+#ifndef __linux__
+    if (a.camera_cfg.v4l2) {
+        log_warn("") << "--v4l2 is only supported on Linux - using OpenCV capture.";
+        a.camera_cfg.v4l2 = false;
+    }
+#endif
+    if (a.watch.enabled()) {
+        // 画像は 1 枚ずつ独立に分類する (待ち時間も前後の画像との比較も不要)
+        a.cooldown = 0;
+        if (a.backend.multi_frames > 1 || a.backend.frame_select != FrameSelect::Latest)
+            log_warn("") << "--watch classifies each image alone - --multi-frame / --frame-select ignored.";
+        a.backend.multi_frames = 1;
+        a.backend.frame_select = FrameSelect::Latest;
+        // 品質ゲートは取り込み側で判定し、除外した画像にも結果を書く
+        a.watch.quality = a.backend.quality;
+        a.backend.quality.enabled = false;
+    }
+    if (!a.diagnose && !a.list_cameras && a.profile.prompt_files.empty() && a.prompts.empty()) {
+        log_error("") << "Error: --prompts required."; std::exit(1);
     }
     return a;
 }
 
 int main(int argc, char* argv[]) {
     auto args = parse(argc, argv);
+    Logger::instance().configure(args.log_level, args.log_json, args.log_queue);
     if (args.diagnose) return Backend::diagnose_device() ? 0 : 1;
+    if (args.list_cameras) {
+        auto cams = enumerate_cameras();
+        for (const auto& c : cams)
+            log_info("") << "  [" << c.index << "] " << c.path << "  " << c.name
+                         << "  (" << c.driver << ", " << c.bus << ")";
+        if (cams.empty()) log_info("") << "No V4L2 capture devices found.";
+        return 0;
+    }
+    if (!args.profile.prompt_files.empty()) return run_prompt_profile(args.profile);
 
     json prompts;
     {
         std::ifstream f(args.prompts);
-        if (!f.is_open()) { std::cerr << "Cannot open " << args.prompts << std::endl; return 1; }
+        if (!f.is_open()) { log_error("") << "Cannot open " << args.prompts; return 1; }
         try { f >> prompts; }
-        catch (const json::parse_error& e) { std::cerr << "Bad JSON: " << e.what() << std::endl; return 1; }
+        catch (const json::parse_error& e) { log_error("") << "Bad JSON: " << e.what(); return 1; }
+    }
+
+    if (!args.trace.empty()) {
+        if (VLM_ENABLE_TRACE) trace::enable(args.trace_events);
+        else log_warn("") << "Warning: built with VLM_ENABLE_TRACE=OFF, --trace ignored.";
     }
 
-    std::string input_str = args.video.empty()
-        ? "Camera " + std::to_string(args.camera) : args.video;
+    std::string input_str = args.watch.enabled() ? "Watch " + args.watch.dir
+        : args.video.empty() ? "Camera " + std::to_string(args.camera) : args.video;
 
-    std::cout << "VLM App (C++ / HailoRT 5.2.0)\n"
-              << "  HEF:      " << args.hef << "\n"
-              << "  Input:    " << input_str << "\n"
-              << "  Scale:    " << args.scale << "\n"
-              << "  Cooldown: " << args.cooldown << " ms" << std::endl;
+    log_info("") << "VLM App (C++ / HailoRT 5.2.0)\n"
+                 << "  HEF:      " << args.hef << "\n"
+                 << "  Input:    " << input_str << "\n"
+                 << "  Scale:    " << args.scale << "\n"
+                 << "  Cooldown: " << args.cooldown << " ms";
+    if (args.backend.thermal.enabled())
+        log_info("") << "  Thermal:  " << args.backend.thermal.throttle_start_c << "-"
+                     << args.backend.thermal.limit_c << " C";
 
+    int rc = 0;
     try {
-        App(prompts, args.camera, args.video, args.hef,
-            args.cooldown, args.scale).run();
+        rc = App(prompts, args.camera, args.video, args.hef,
+                 args.cooldown, args.scale, args.backend, args.soak,
+                 args.capture_policy, args.trace, args.clip,
+                 args.output_video, args.output_queue, args.aggregate_interval, args.watch, args.camera_cfg).run();
     }
-    catch (const std::exception& e) { std::cerr << "Fatal: " << e.what() << std::endl; return 1; }
+    catch (const std::exception& e) { log_error("") << "Fatal: " << e.what(); return 1; }
 
-    std::cout << "Exited." << std::endl;
-    return 0;
+    log_info("") << "Exited.";
+    return rc;
 }
\ No newline at end of file
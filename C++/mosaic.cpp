@@ -0,0 +1,145 @@
+// =============================================================================
+//  mosaic.cpp - 複数ビューを 1 枚のモデル入力にまとめるモザイク前処理
+// =============================================================================
+
+#include "mosaic.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <regex>
+#include <sstream>
+
+// =============================================================================
+bool parse_mosaic_layout(const std::string& spec, std::vector<cv::Rect2d>& rois) {
+    rois.clear();
+    if (spec.rfind("grid:", 0) == 0) {
+        int cols = 0, rows = 0;
+        if (std::sscanf(spec.c_str() + 5, "%dx%d", &cols, &rows) != 2 ||
+            cols <= 0 || rows <= 0)
+            return false;
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+                rois.emplace_back((double)c / cols, (double)r / rows,
+                                  1.0 / cols, 1.0 / rows);
+        return rois.size() >= 2;
+    }
+
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        if (item.empty()) continue;
+        double x, y, w, h;
+        if (std::sscanf(item.c_str(), "%lf,%lf,%lf,%lf", &x, &y, &w, &h) != 4 ||
+            w <= 0.0 || h <= 0.0 || x < 0.0 || y < 0.0 || x + w > 1.0001 || y + h > 1.0001)
+            return false;
+        rois.emplace_back(x, y, w, h);
+    }
+    return rois.size() >= 2;
+}
+
+cv::Size mosaic_grid(size_t n) {
+    int cols = (int)std::ceil(std::sqrt((double)n));
+    int rows = (int)((n + cols - 1) / cols);
+    return cv::Size(cols, rows);
+}
+
+// =============================================================================
+cv::Mat compose_mosaic(const cv::Mat& frame, const std::vector<cv::Rect2d>& rois,
+                       int out_w, int out_h)
+{
+    cv::Mat out(out_h, out_w, CV_8UC3, cv::Scalar(0, 0, 0));
+    if (frame.empty() || rois.empty()) return out;
+
+    const cv::Size grid = mosaic_grid(rois.size());
+    const int tw = out_w / grid.width;
+    const int th = out_h / grid.height;
+    const double font_scale = std::max(0.3, th / 200.0);
+
+    for (size_t i = 0; i < rois.size(); i++) {
+        const auto& r = rois[i];
+        cv::Rect src((int)(r.x * frame.cols), (int)(r.y * frame.rows),
+                     (int)(r.width * frame.cols), (int)(r.height * frame.rows));
+        src.width  = std::min(src.width,  frame.cols - src.x);
+        src.height = std::min(src.height, frame.rows - src.y);
+        if (src.width <= 0 || src.height <= 0) continue;
+
+        // 縦横比を保ってタイル内に収める (余白は黒)
+        double s = std::min((double)tw / src.width, (double)th / src.height);
+        int w = std::max(1, (int)(src.width * s));
+        int h = std::max(1, (int)(src.height * s));
+        int cx = (int)(i % grid.width) * tw;
+        int cy = (int)(i / grid.width) * th;
+        cv::Rect dst(cx + (tw - w) / 2, cy + (th - h) / 2, w, h);
+
+        cv::Mat tile = out(dst);
+        cv::resize(frame(src), tile, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+
+        cv::putText(out, std::to_string(i + 1), cv::Point(cx + 4, cy + (int)(22 * font_scale)),
+                    cv::FONT_HERSHEY_SIMPLEX, font_scale, cv::Scalar(0, 255, 255), 1, cv::LINE_AA);
+    }
+    // タイル境界
+    for (int c = 1; c < grid.width; c++)
+        cv::line(out, cv::Point(c * tw, 0), cv::Point(c * tw, out_h - 1), cv::Scalar(255, 255, 255), 1);
+    for (int r = 1; r < grid.height; r++)
+        cv::line(out, cv::Point(0, r * th), cv::Point(out_w - 1, r * th), cv::Scalar(255, 255, 255), 1);
+    return out;
+}
+
+// =============================================================================
+std::vector<std::string> parse_numbered_answers(const std::string& response, size_t n) {
+    std::vector<std::string> out(n);
+
+    // 番号の前に "view" / "tile" / "camera" / "#" / "(" が付く場合も許容
+    static const std::regex re(R"((?:^|[\s,;(\[])(?:view|tile|camera|image|q)?\s*#?(\d+)\s*[:.)\]-]\s*)",
+                               std::regex::icase);
+    // 行頭 (前が空白だけ) の番号
+    auto at_line_start = [&](size_t pos) {
+        if (response[pos] == '\n') return true;
+        size_t nl = response.rfind('\n', pos);
+        size_t from = (nl == std::string::npos) ? 0 : nl + 1;
+        return response.find_first_not_of(" \t\r", from) >= pos;
+    };
+    struct Mark { size_t pos, len, idx; bool line_start; };
+    std::vector<Mark> marks;
+    for (auto it = std::sregex_iterator(response.begin(), response.end(), re);
+         it != std::sregex_iterator(); ++it) {
+        if (it->length(1) > 4) continue;
+        size_t idx = std::stoul((*it)[1].str());
+        size_t pos = (size_t)it->position(0);
+        if (idx >= 1 && idx <= n)
+            marks.push_back({pos, (size_t)it->length(0), idx, at_line_start(pos)});
+    }
+
+    // 区切りとみなすのは昇順に現れる番号だけ。回答中の数字を区切りと誤らないよう:
+    //  - 番号を飛ばすのは、飛ばした番号が後に出てこない場合に限る
+    //    ("1: aisle 4) blocked\n2: ok" の 4 は回答の一部)
+    //  - 同じ番号が後で行頭に出てくるなら、行の途中のものは回答の一部
+    std::vector<Mark> bounds;
+    size_t last = 0;
+    for (size_t i = 0; i < marks.size(); i++) {
+        const Mark& m = marks[i];
+        if (m.idx <= last) continue;
+        auto later = [&](auto pred) { return std::any_of(marks.begin() + i + 1, marks.end(), pred); };
+        if (m.idx > last + 1 && later([&](const Mark& o) { return o.idx == last + 1; }))
+            continue;
+        if (!m.line_start && later([&](const Mark& o) { return o.idx == m.idx && o.line_start; }))
+            continue;
+        bounds.push_back(m);
+        last = m.idx;
+    }
+
+    auto trim = [](std::string s) {
+        const char* ws = " \t\r\n,;.'\"";
+        auto l = s.find_first_not_of(ws);
+        auto r = s.find_last_not_of(ws);
+        return (l != std::string::npos) ? s.substr(l, r - l + 1) : std::string();
+    };
+
+    for (size_t i = 0; i < bounds.size(); i++) {
+        size_t begin = bounds[i].pos + bounds[i].len;
+        size_t end = (i + 1 < bounds.size()) ? bounds[i + 1].pos : response.size();
+        if (end > begin) out[bounds[i].idx - 1] = trim(response.substr(begin, end - begin));
+    }
+    return out;
+}
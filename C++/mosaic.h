@@ -0,0 +1,33 @@
+#pragma once
+// =============================================================================
+//  mosaic.h - 複数ビューを 1 枚のモデル入力にまとめるモザイク前処理
+//
+//  モデル入力 (例: 336x336) と 1 サイクル 1 回の generate では、N 台の
+//  低解像度カメラを監視するのに N 回の推論が必要になる。
+//  各ビュー (入力フレームの ROI。マルチビュー出力のレコーダー映像など) を
+//  縮小してグリッド状に並べ、番号付きで 1 回に問い合わせる。
+//
+//  レイアウト指定:
+//    "grid:2x2"                  入力を 2x2 に等分
+//    "x,y,w,h;x,y,w,h;..."       正規化座標 (0..1) の ROI を列挙
+// =============================================================================
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// spec を解析 (ビューが 2 つ未満なら false)
+bool parse_mosaic_layout(const std::string& spec, std::vector<cv::Rect2d>& rois);
+
+// n ビューを並べるグリッド (cols x rows)
+cv::Size mosaic_grid(size_t n);
+
+// 各 ROI を縦横比を保って縮小し、out_w x out_h のグリッドに配置 (BGR)
+// タイル左上にビュー番号 (1 始まり) を描画する
+cv::Mat compose_mosaic(const cv::Mat& frame, const std::vector<cv::Rect2d>& rois,
+                       int out_w, int out_h);
+
+// "1: empty\n2: pickup" / "1) yes, 2) no" 形式の回答を n 個に分解
+// 見つからない番号は空文字列
+std::vector<std::string> parse_numbered_answers(const std::string& response, size_t n);
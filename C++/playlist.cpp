@@ -0,0 +1,96 @@
+// =============================================================================
+//  playlist.cpp - 動画プレイリストの切れ目のない再生
+// =============================================================================
+
+#include "playlist.h"
+#include "logger.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+// =============================================================================
+PlaylistPlayer::PlaylistPlayer(std::vector<std::string> files, ThreadPool& pool, size_t preroll)
+    : m_files(std::move(files)), m_pool(pool), m_preroll(preroll)
+{
+}
+
+PlaylistPlayer::Source PlaylistPlayer::open_source(size_t index, const std::string& path,
+                                                   size_t preroll) {
+    VLM_TRACE_SCOPE("open_video");
+    Source s;
+    s.index = index;
+    s.cap = std::make_unique<cv::VideoCapture>(path);
+    // 最初の read() はデコーダー初期化を含むので、ここで済ませておく
+    while (s.cap->isOpened() && s.preroll.size() < preroll) {
+        cv::Mat f;
+        if (!s.cap->read(f) || f.empty()) break;
+        s.preroll.push_back(std::move(f));
+    }
+    return s;
+}
+
+bool PlaylistPlayer::open() {
+    if (m_files.empty()) return false;
+    m_cur = open_source(0, m_files[0], m_preroll);
+    if (!m_cur.cap->isOpened()) {
+        log_error("Playlist") << "Cannot open: " << m_files[0];
+        return false;
+    }
+    prefetch(1 % m_files.size());
+    return true;
+}
+
+void PlaylistPlayer::prefetch(size_t index) {
+    m_next_index = index;
+    m_next_claimed = std::make_shared<std::atomic<bool>>(false);
+    auto claimed = m_next_claimed;
+    const std::string path = m_files[index];
+    const size_t preroll = m_preroll;
+    try {
+        m_next = m_pool.submit([claimed, index, path, preroll] {
+            // 切り替え時にその場で開かれた後なら何もしない
+            if (claimed->exchange(true)) return Source{};
+            return open_source(index, path, preroll);
+        });
+    } catch (const std::exception&) {
+        m_next = {};   // エグゼキューター停止中: 切り替え時にその場で開く
+    }
+}
+
+bool PlaylistPlayer::advance() {
+    const size_t index = m_next_index;
+    Source next;
+    // 未着手ならその場で開く (キューに残ったタスクは実行されても開かずに戻る)
+    if (m_next.valid() && m_next_claimed->exchange(true)) {
+        try { next = m_next.get(); } catch (...) {}
+    }
+    if (!next.cap) {
+        m_inline_opens++;
+        next = open_source(index, m_files[index], m_preroll);
+    }
+    m_next = {};
+    if (!next.cap->isOpened()) {
+        log_error("Playlist") << "Cannot open: " << m_files[index];
+        return false;
+    }
+    m_cur = std::move(next);
+    m_switches++;
+    prefetch((index + 1) % m_files.size());
+    return true;
+}
+
+bool PlaylistPlayer::read(cv::Mat& frame, bool& switched) {
+    switched = false;
+    // フレームのないファイルが続いても 1 周で止める
+    for (size_t tries = 0; tries <= m_files.size(); tries++) {
+        if (!m_cur.preroll.empty()) {
+            frame = std::move(m_cur.preroll.front());
+            m_cur.preroll.pop_front();
+            return true;
+        }
+        if (m_cur.cap->read(frame) && !frame.empty()) return true;
+        if (!advance()) return false;
+        switched = true;
+    }
+    log_error("Playlist") << "No readable frames in playlist.";
+    return false;
+}
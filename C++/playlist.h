@@ -0,0 +1,67 @@
+#pragma once
+// =============================================================================
+//  playlist.h - 動画プレイリストの切れ目のない再生
+//
+//  ファイル末尾でフレームループ内から cap.open するとコンテナ解析の間
+//  表示とフレーム供給が止まる (短いクリップを多数並べたデモ / 検証用の
+//  プレイリストでは、その時間が無視できない)。ここでは:
+//    - 再生中に次のファイルを共有エグゼキューターで開き、先頭 preroll 枚まで
+//      デコードしておく。切り替えはキャプチャのポインター差し替えだけ
+//    - 切り替え時に先読みが未着手 (エグゼキューターが推論で埋まっている等) なら
+//      従来どおりその場で開く。実行中なら完了を待つ
+//    - 末尾の次は先頭 (ループ再生)
+// =============================================================================
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+class ThreadPool;
+
+// =============================================================================
+class PlaylistPlayer {
+public:
+    PlaylistPlayer(std::vector<std::string> files, ThreadPool& pool, size_t preroll = 3);
+
+    PlaylistPlayer(const PlaylistPlayer&) = delete;
+    PlaylistPlayer& operator=(const PlaylistPlayer&) = delete;
+
+    // 先頭を開き (同期)、次の先読みを開始する
+    bool open();
+    // 次のフレーム。ファイル末尾では次のファイルに切り替えて switched = true
+    // (次のファイルも開けなければ false)
+    bool read(cv::Mat& frame, bool& switched);
+
+    const cv::VideoCapture& capture() const { return *m_cur.cap; }
+    const std::string& path() const { return m_files[m_cur.index]; }
+
+    uint64_t switches() const { return m_switches; }
+    uint64_t inline_opens() const { return m_inline_opens; }   // 先読みが間に合わなかった回数
+
+private:
+    struct Source {
+        size_t index = 0;
+        std::unique_ptr<cv::VideoCapture> cap;
+        std::deque<cv::Mat> preroll;   // 開いた直後にデコードした先頭フレーム
+    };
+    static Source open_source(size_t index, const std::string& path, size_t preroll);
+    void prefetch(size_t index);
+    bool advance();
+
+    std::vector<std::string> m_files;
+    ThreadPool& m_pool;
+    size_t m_preroll;
+    Source m_cur;
+    std::future<Source> m_next;
+    // 先読みタスクと advance() のうち先に立てた側が開く (遅れた側は開かない)
+    std::shared_ptr<std::atomic<bool>> m_next_claimed;
+    size_t m_next_index = 0;
+    uint64_t m_switches = 0;
+    uint64_t m_inline_opens = 0;
+};
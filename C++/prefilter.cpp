@@ -0,0 +1,172 @@
+// =============================================================================
+//  prefilter.cpp - VLM の前段に置く軽量な CPU フィルタ (カスケード)
+// =============================================================================
+
+#include "prefilter.h"
+#include "trace.h"
+
+#include <algorithm>
+
+using json = nlohmann::json;
+
+namespace {
+
+cv::Mat downscale(const cv::Mat& frame, int width) {
+    if (width <= 0 || frame.cols <= width) return frame;
+    cv::Mat small;
+    int h = std::max(1, frame.rows * width / frame.cols);
+    cv::resize(frame, small, cv::Size(width, h), 0, 0, cv::INTER_AREA);
+    return small;
+}
+
+// =============================================================================
+//  hog: OpenCV 既定の人物検出器
+//    検出なし → 陰性 / score >= confident → 陽性 / それ以外 → 不確実
+// =============================================================================
+class HogPersonFilter : public PreFilter {
+public:
+    explicit HogPersonFilter(const json& cfg)
+        : m_width(cfg.value("width", 480)),
+          m_hit_threshold(cfg.value("hit_threshold", 0.0)),
+          m_confident(cfg.value("confident_score", 1.0))
+    {
+        m_hog.setSVMDetector(cv::HOGDescriptor::getDefaultPeopleDetector());
+    }
+
+    const char* name() const override { return "hog"; }
+
+    PreFilterResult evaluate(const cv::Mat& frame, const ForegroundStats*) override {
+        VLM_TRACE_SCOPE("prefilter_hog");
+        cv::Mat small = downscale(frame, m_width);
+        std::vector<cv::Rect> found;
+        std::vector<double> weights;
+        m_hog.detectMultiScale(small, found, weights, m_hit_threshold,
+                               cv::Size(8, 8), cv::Size(), 1.05, 2.0, false);
+        PreFilterResult r;
+        for (double w : weights) r.score = std::max(r.score, w);
+        if (found.empty())               r.decision = PreFilterDecision::Negative;
+        else if (r.score >= m_confident) r.decision = PreFilterDecision::Positive;
+        return r;
+    }
+
+private:
+    int m_width;
+    double m_hit_threshold;
+    double m_confident;
+    cv::HOGDescriptor m_hog;
+};
+
+// =============================================================================
+//  foreground: 低解像度の背景差分 (MOG2) による前景率
+//    前景率 < max_ratio → 陰性 / >= positive_ratio → 陽性
+//    学習が落ち着くまでの warmup フレームは不確実
+// =============================================================================
+class ForegroundFilter : public PreFilter {
+public:
+    explicit ForegroundFilter(const json& cfg)
+        : m_width(cfg.value("width", 160)),
+          m_max_ratio(cfg.value("max_ratio", 0.002)),
+          m_positive_ratio(cfg.value("positive_ratio", 0.02)),
+          m_warmup(cfg.value("warmup", 5))
+    {
+        m_mog = cv::createBackgroundSubtractorMOG2(cfg.value("history", 50), 16.0, false);
+    }
+
+    const char* name() const override { return "foreground"; }
+
+    PreFilterResult evaluate(const cv::Mat& frame, const ForegroundStats* fg) override {
+        VLM_TRACE_SCOPE("prefilter_fg");
+        PreFilterResult r;
+        if (fg && fg->valid) {
+            // キャプチャスレッドの背景モデルは全フレームを見ているのでそちらを使う
+            r.score = fg->ratio;
+        } else {
+            cv::Mat small = downscale(frame, m_width), mask;
+            m_mog->apply(small, mask);
+            // 1px のノイズを除去
+            static const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+            cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
+            r.score = (double)cv::countNonZero(mask) / std::max(1, mask.rows * mask.cols);
+        }
+        if (m_seen++ < m_warmup)              r.decision = PreFilterDecision::Uncertain;
+        else if (r.score < m_max_ratio)       r.decision = PreFilterDecision::Negative;
+        else if (r.score >= m_positive_ratio) r.decision = PreFilterDecision::Positive;
+        return r;
+    }
+
+private:
+    int m_width;
+    double m_max_ratio;
+    double m_positive_ratio;
+    int m_warmup;
+    int m_seen = 0;
+    cv::Ptr<cv::BackgroundSubtractorMOG2> m_mog;
+};
+
+// =============================================================================
+//  histogram: 基準画像 (例: 空の棚) との H-S ヒストグラム相関
+//    相関 >= min_similarity → 陰性 (基準と同じ状態) / それ以外 → 不確実
+// =============================================================================
+class HistogramFilter : public PreFilter {
+public:
+    HistogramFilter(const json& cfg, const cv::Mat& reference)
+        : m_width(cfg.value("width", 160)),
+          m_min_similarity(cfg.value("min_similarity", 0.95))
+    {
+        m_reference = histogram(reference);
+    }
+
+    const char* name() const override { return "histogram"; }
+
+    PreFilterResult evaluate(const cv::Mat& frame, const ForegroundStats*) override {
+        VLM_TRACE_SCOPE("prefilter_hist");
+        PreFilterResult r;
+        r.score = cv::compareHist(histogram(frame), m_reference, cv::HISTCMP_CORREL);
+        if (r.score >= m_min_similarity) r.decision = PreFilterDecision::Negative;
+        return r;
+    }
+
+private:
+    cv::Mat histogram(const cv::Mat& frame) const {
+        cv::Mat hsv, hist;
+        cv::cvtColor(downscale(frame, m_width), hsv, cv::COLOR_BGR2HSV);
+        const int channels[] = {0, 1};
+        const int bins[] = {30, 32};
+        const float h_range[] = {0, 180}, s_range[] = {0, 256};
+        const float* ranges[] = {h_range, s_range};
+        cv::calcHist(&hsv, 1, channels, cv::Mat(), hist, 2, bins, ranges);
+        cv::normalize(hist, hist, 1.0, 0.0, cv::NORM_L1);
+        return hist;
+    }
+
+    int m_width;
+    double m_min_similarity;
+    cv::Mat m_reference;
+};
+
+} // namespace
+
+// =============================================================================
+std::unique_ptr<PreFilter> create_prefilter(const json& cfg, std::string& error) {
+    if (!cfg.is_object()) { error = "prefilter must be an object"; return nullptr; }
+    const std::string type = cfg.value("type", "");
+    if (type == "hog") return std::make_unique<HogPersonFilter>(cfg);
+    if (type == "foreground") return std::make_unique<ForegroundFilter>(cfg);
+    if (type == "histogram") {
+        const std::string path = cfg.value("reference", "");
+        cv::Mat ref = path.empty() ? cv::Mat() : cv::imread(path);
+        if (ref.empty()) { error = "cannot read reference image '" + path + "'"; return nullptr; }
+        return std::make_unique<HistogramFilter>(cfg, ref);
+    }
+    error = "unknown prefilter type '" + type + "' (hog|foreground|histogram)";
+    return nullptr;
+}
+
+const char* prefilter_decision_name(PreFilterDecision d) {
+    switch (d) {
+        case PreFilterDecision::Negative:  return "negative";
+        case PreFilterDecision::Positive:  return "positive";
+        case PreFilterDecision::Uncertain: return "uncertain";
+    }
+    return "?";
+}
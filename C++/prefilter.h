@@ -0,0 +1,48 @@
+#pragma once
+// =============================================================================
+//  prefilter.h - VLM の前段に置く軽量な CPU フィルタ (カスケード)
+//
+//  カメラの大半の時間は「誰もいない」「棚は空のまま」といった自明な状態で、
+//  そのたびに 2B VLM を数秒回すのは無駄が大きい。
+//  古典的な検出器で判定し、確信をもって陰性と言えるフレームは VLM を呼ばずに
+//  設定した回答を返す。陽性 / 判断が付かないフレームだけ VLM に回す。
+//
+//  プロンプト JSON の use case に "prefilter" を書いて有効化する:
+//    "prefilter": {"type": "hog",        "answer": "no person"}
+//    "prefilter": {"type": "foreground", "answer": "no person", "max_ratio": 0.002}
+//    "prefilter": {"type": "histogram",  "answer": "empty", "reference": "empty_shelf.jpg"}
+// =============================================================================
+
+#include <memory>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+#include <nlohmann/json.hpp>
+
+#include "background_model.h"
+
+enum class PreFilterDecision {
+    Negative,    // 確信をもって陰性 → VLM を呼ばない
+    Positive,    // 陽性 → VLM で詳細を判定
+    Uncertain,   // 判断できない → VLM に回す
+};
+
+struct PreFilterResult {
+    PreFilterDecision decision = PreFilterDecision::Uncertain;
+    double score = 0.0;          // フィルタ固有の値 (HOG 最大スコア / 前景率 / 類似度)
+};
+
+// =============================================================================
+class PreFilter {
+public:
+    virtual ~PreFilter() = default;
+    virtual const char* name() const = 0;
+    // 監視スレッドから 1 サイクルに 1 回呼ばれる (BGR)
+    // fg: キャプチャスレッドの背景モデルの結果 (無効時は nullptr)
+    virtual PreFilterResult evaluate(const cv::Mat& frame, const ForegroundStats* fg) = 0;
+};
+
+// "prefilter" の設定から作成 (不正な設定なら nullptr と error)
+std::unique_ptr<PreFilter> create_prefilter(const nlohmann::json& cfg, std::string& error);
+
+const char* prefilter_decision_name(PreFilterDecision d);
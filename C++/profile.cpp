@@ -0,0 +1,225 @@
+// =============================================================================
+//  profile.cpp - プロンプトのコスト計測 (--profile)
+// =============================================================================
+
+#include "profile.h"
+#include "backend.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+
+struct Sample {
+    double ttft_ms = 0.0;
+    double decode_ms = 0.0;     // 最初のトークン → 最後のトークン
+    double total_ms = 0.0;
+    size_t input_tokens = 0;
+    size_t output_tokens = 0;
+};
+
+struct Row {
+    std::string file, use_case;
+    size_t system_tokens = 0, details_tokens = 0, user_tokens = 0;
+    size_t input_tokens = 0, output_tokens = 0;
+    double ttft_ms = 0.0, prefill_ms = 0.0, per_token_ms = 0.0, total_ms = 0.0;
+};
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t m = v.size() / 2;
+    return (v.size() % 2) ? v[m] : (v[m - 1] + v[m]) / 2.0;
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0,
+                std::chrono::steady_clock::time_point t1) {
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+} // namespace
+
+// =============================================================================
+int run_prompt_profile(const ProfileConfig& cfg) {
+    if (cfg.prompt_files.empty()) {
+        log_error("Profile") << "No prompt files.";
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, json>> files;
+    for (const auto& path : cfg.prompt_files) {
+        std::ifstream f(path);
+        if (!f.is_open()) { log_error("Profile") << "Cannot open " << path; return 1; }
+        json j;
+        try { f >> j; }
+        catch (const json::parse_error& e) {
+            log_error("Profile") << "Bad JSON in " << path << ": " << e.what();
+            return 1;
+        }
+        files.emplace_back(std::filesystem::path(path).filename().string(), std::move(j));
+    }
+
+    cv::Mat image;
+    if (!cfg.image.empty()) {
+        image = cv::imread(cfg.image);
+        if (image.empty()) { log_error("Profile") << "Cannot read image " << cfg.image; return 1; }
+    }
+
+    auto vr = hailort::VDevice::create_shared();
+    if (!vr) {
+        log_error("Profile").field("status", (int)vr.status()) << "Cannot create VDevice";
+        return 1;
+    }
+    auto vdevice = vr.release();
+
+    const int runs = std::max(1, cfg.runs);
+    std::vector<Row> rows;
+    try {
+        log_info("Profile") << "Loading VLM: " << cfg.hef;
+        auto lr = hailort::genai::VLM::create(vdevice, hailort::genai::VLMParams(cfg.hef, true));
+        if (!lr) {
+            log_error("Profile").field("status", (int)lr.status()) << "VLM::create failed";
+            return 1;
+        }
+        auto vlm = lr.release();
+
+        auto shape = vlm.input_frame_shape();
+        const uint32_t frame_size = vlm.input_frame_size();
+        if (image.empty())
+            image = cv::Mat((int)shape.height, (int)shape.width, CV_8UC3, cv::Scalar(128, 128, 128));
+        cv::Mat rgb = Backend::preprocess_image(image, (int)shape.height, (int)shape.width);
+        std::vector<hailort::MemoryView> frames{hailort::MemoryView(rgb.data, frame_size)};
+
+        auto count_tokens = [&](const std::string& text) -> size_t {
+            if (text.empty()) return 0;
+            auto r = vlm.tokenize(text);
+            return r ? r.value().size() : 0;
+        };
+
+        for (const auto& [file, prompts] : files) {
+            const std::string sys = prompts.value("hailo_system_prompt", "");
+            const std::string usr = prompts.value("hailo_user_prompt", "");
+
+            std::vector<std::string> names;
+            if (prompts.contains("use_cases"))
+                for (const auto& [name, uc] : prompts["use_cases"].items()) names.push_back(name);
+            if (names.empty()) names.push_back("-");
+
+            for (const auto& name : names) {
+                const json uc = (name != "-") ? prompts["use_cases"][name] : json::object();
+                const std::string details = uc.value("details", "");
+                std::string user_text = usr;
+                auto p = user_text.find("{details}");
+                if (p != std::string::npos) user_text.replace(p, 9, details);
+
+                // 監視ループと同じ既定値 (max_tokens "auto" は既定の上限で測る)
+                const json gen = uc.value("generation", json::object());
+                uint32_t max_tokens = 15;
+                if (gen.contains("max_tokens") && gen["max_tokens"].is_number_integer())
+                    max_tokens = gen["max_tokens"].get<uint32_t>();
+                auto params = vlm.create_generator_params()
+                    .expect("Failed to create generator params");
+                params.set_temperature(gen.value("temperature", 0.1f));
+                params.set_max_generated_tokens(max_tokens);
+                params.set_seed(gen.value("seed", 42u));
+
+                const auto msgs = build_prompt_messages(prompts, name, sys, usr, 1);
+
+                log_info("Profile") << file << " / " << name << ": "
+                                    << runs << " runs (+1 warm-up)";
+                std::vector<Sample> samples;
+                for (int r = 0; r <= runs; r++) {
+                    vlm.clear_context();
+                    Sample s;
+                    const auto t0 = std::chrono::steady_clock::now();
+                    auto completion = vlm.generate(params, msgs, frames)
+                        .expect("Failed to generate (profile)");
+
+                    auto t_first = t0, t_last = t0;
+                    while (completion.generation_status()
+                           == hailort::genai::LLMGeneratorCompletion::Status::GENERATING)
+                    {
+                        auto tok = completion.read(std::chrono::seconds(10));
+                        if (!tok) { try { completion.abort(); } catch (...) {} break; }
+                        t_last = std::chrono::steady_clock::now();
+                        if (s.output_tokens++ == 0) t_first = t_last;
+                        if (s.output_tokens >= max_tokens) {
+                            try { completion.abort(); } catch (...) {}
+                            break;
+                        }
+                    }
+                    s.ttft_ms = ms_since(t0, t_first);
+                    s.decode_ms = ms_since(t_first, t_last);
+                    s.total_ms = ms_since(t0, std::chrono::steady_clock::now());
+                    auto used = vlm.get_context_usage_size();
+                    if (used && used.value() >= s.output_tokens)
+                        s.input_tokens = used.value() - s.output_tokens;
+                    if (r > 0) samples.push_back(s);   // r == 0 はウォームアップ
+                }
+                vlm.clear_context();
+
+                Row row;
+                row.file = file;
+                row.use_case = name;
+                row.system_tokens = count_tokens(sys);
+                row.details_tokens = count_tokens(details);
+                row.user_tokens = count_tokens(user_text);
+                std::vector<double> ttft, per_tok, total, in, out;
+                for (const auto& s : samples) {
+                    ttft.push_back(s.ttft_ms);
+                    total.push_back(s.total_ms);
+                    in.push_back((double)s.input_tokens);
+                    out.push_back((double)s.output_tokens);
+                    if (s.output_tokens > 1) per_tok.push_back(s.decode_ms / (s.output_tokens - 1));
+                }
+                row.ttft_ms = median(ttft);
+                row.per_token_ms = median(per_tok);
+                row.total_ms = median(total);
+                row.input_tokens = (size_t)median(in);
+                row.output_tokens = (size_t)median(out);
+                // 最初のトークンにも 1 回分の decode が含まれる
+                row.prefill_ms = std::max(0.0, row.ttft_ms - row.per_token_ms);
+                rows.push_back(row);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        log_error("Profile") << "Error: " << e.what();
+        return 1;
+    }
+
+    // ---- 結果表 (TTFT は先頭行との差も出す) ----
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(0);
+    o << "\n" << std::string(118, '=') << "\n"
+      << "  Prompt cost profile (median of " << runs << " runs, image "
+      << (cfg.image.empty() ? "gray" : cfg.image) << ")\n"
+      << std::string(118, '=') << "\n"
+      << std::left << std::setw(28) << "  File" << std::setw(16) << "Use case" << std::right
+      << std::setw(7) << "System" << std::setw(8) << "Details" << std::setw(6) << "User"
+      << std::setw(8) << "Image+" << std::setw(7) << "Input" << std::setw(5) << "Out"
+      << std::setw(9) << "TTFT ms" << std::setw(11) << "Prefill ms" << std::setw(9) << "ms/tok"
+      << std::setw(10) << "Total ms" << "  dTTFT\n"
+      << std::string(118, '-') << "\n";
+    for (const auto& r : rows) {
+        const size_t text = r.system_tokens + r.user_tokens;
+        const long image_tokens = (long)r.input_tokens - (long)text;   // 画像 + テンプレート
+        std::ostringstream d;
+        d << std::fixed << std::setprecision(0) << std::showpos << (r.ttft_ms - rows.front().ttft_ms);
+        o << "  " << std::left << std::setw(26) << r.file.substr(0, 25)
+          << std::setw(16) << r.use_case.substr(0, 15) << std::right
+          << std::setw(7) << r.system_tokens << std::setw(8) << r.details_tokens
+          << std::setw(6) << r.user_tokens << std::setw(8) << std::max(0L, image_tokens)
+          << std::setw(7) << r.input_tokens << std::setw(5) << r.output_tokens
+          << std::setw(9) << r.ttft_ms << std::setw(11) << r.prefill_ms
+          << std::setprecision(1) << std::setw(9) << r.per_token_ms << std::setprecision(0)
+          << std::setw(10) << r.total_ms << "  " << d.str() << "\n";
+    }
+    o << std::string(118, '-') << "\n"
+      << "  User includes Details. Image+ = Input - System - User (image + chat template).\n";
+    log_raw(o.str());
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+// =============================================================================
+//  profile.h - プロンプトのコスト計測 (--profile)
+//
+//  hailo_system_prompt / details / 画像がそれぞれ何トークンを占め、
+//  prefill・decode・最初のトークンまでの時間 (TTFT) にどう効くかを測る。
+//  監視ループと同じメッセージを use case ごとに作って実行し、
+//  複数のプロンプトファイル (同じプロンプトの短縮版など) を並べて比較する。
+//
+//  - 1 回のウォームアップ後 runs 回実行し、中央値を出す
+//  - 入力トークン数 = 生成後のコンテキスト使用量 - 生成トークン数
+//  - prefill ≈ TTFT - 1 トークンあたりの decode 時間
+// =============================================================================
+
+#include <string>
+#include <vector>
+
+// =============================================================================
+struct ProfileConfig {
+    std::vector<std::string> prompt_files;
+    std::string hef = "Qwen2-VL-2B-Instruct.hef";
+    std::string image;       // 空ならグレー画像 (画像トークン数は内容に依らない)
+    int runs = 3;
+};
+
+// 計測して表を出力する (終了コードを返す)
+int run_prompt_profile(const ProfileConfig& cfg);
@@ -0,0 +1,230 @@
+// =============================================================================
+//  publisher.cpp - Unix ドメインソケットによるローカル配信 (publish/subscribe)
+// =============================================================================
+
+#include "publisher.h"
+#include "logger.h"
+#include "thread_util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+#ifdef _WIN32
+constexpr uintptr_t kInvalid = (uintptr_t)INVALID_SOCKET;
+void close_socket(uintptr_t s) { closesocket((SOCKET)s); }
+bool would_block() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+void set_nonblocking(uintptr_t s) { u_long on = 1; ioctlsocket((SOCKET)s, FIONBIO, &on); }
+constexpr int kSendFlags = 0;
+#else
+constexpr int kInvalid = -1;
+void close_socket(int s) { ::close(s); }
+bool would_block() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+void set_nonblocking(int s) { fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK); }
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;   // 切断済みソケットへの書き込みで SIGPIPE を出さない
+#else
+constexpr int kSendFlags = 0;
+#endif
+#endif
+
+} // namespace
+
+bool parse_drop_policy(const std::string& s, DropPolicy& out) {
+    if (s == "oldest")          out = DropPolicy::Oldest;
+    else if (s == "newest")     out = DropPolicy::Newest;
+    else if (s == "disconnect") out = DropPolicy::Disconnect;
+    else return false;
+    return true;
+}
+
+// =============================================================================
+ResultPublisher::ResultPublisher(const PublisherConfig& cfg)
+    : m_cfg(cfg), m_listen((socket_t)kInvalid)
+{
+    m_cfg.queue_limit = std::max<size_t>(1, m_cfg.queue_limit);
+    m_cfg.batch_max = std::max<size_t>(1, m_cfg.batch_max);
+    m_cfg.batch_ms = std::max(1, m_cfg.batch_ms);
+}
+
+ResultPublisher::~ResultPublisher() { close(); }
+
+bool ResultPublisher::start() {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        log_error("Publish") << "WSAStartup failed";
+        return false;
+    }
+#endif
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (m_cfg.path.size() >= sizeof(addr.sun_path)) {
+        log_error("Publish") << "Socket path too long: " << m_cfg.path;
+        return false;
+    }
+    std::memcpy(addr.sun_path, m_cfg.path.c_str(), m_cfg.path.size() + 1);
+
+    // 前回の実行で残ったソケットファイルは削除 (通常ファイルは消さない)
+    // Windows の AF_UNIX ソケットは reparse point で is_socket が使えないため存在で判定
+    std::error_code ec;
+#ifdef _WIN32
+    if (fs::exists(m_cfg.path, ec)) fs::remove(m_cfg.path, ec);
+#else
+    if (fs::is_socket(m_cfg.path, ec)) fs::remove(m_cfg.path, ec);
+#endif
+    if (fs::exists(m_cfg.path, ec)) {
+        log_error("Publish") << "Path exists and is not a socket: " << m_cfg.path;
+        return false;
+    }
+
+    m_listen = (socket_t)socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listen == (socket_t)kInvalid) {
+        log_error("Publish") << "socket() failed";
+        return false;
+    }
+    if (bind(m_listen, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(m_listen, 8) != 0) {
+        log_error("Publish") << "Cannot listen on " << m_cfg.path;
+        close_socket(m_listen);
+        m_listen = (socket_t)kInvalid;
+        return false;
+    }
+    set_nonblocking(m_listen);
+
+    m_running = true;
+    m_thread = std::thread(&ResultPublisher::io_loop, this);
+    log_info("Publish") << "Listening on " << m_cfg.path << " (queue " << m_cfg.queue_limit
+                        << ", batch " << m_cfg.batch_ms << "ms)";
+    return true;
+}
+
+void ResultPublisher::close() {
+    if (!m_running.exchange(false)) return;
+    if (m_thread.joinable()) m_thread.join();
+
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (auto& s : m_subs) close_socket(s->fd);
+    m_subs.clear();
+    close_socket(m_listen);
+    m_listen = (socket_t)kInvalid;
+    std::error_code ec;
+    fs::remove(m_cfg.path, ec);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    log_info("Publish") << "Closed (published " << m_published.load()
+                        << ", dropped " << m_dropped.load() << ")";
+}
+
+size_t ResultPublisher::subscribers() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_subs.size();
+}
+
+// =============================================================================
+void ResultPublisher::publish(const std::string& line) {
+    if (!m_running) return;
+    m_published++;
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (auto& s : m_subs) {
+        if (s->closed) continue;
+        if (s->queue.size() >= m_cfg.queue_limit) {
+            m_dropped++;
+            if (m_cfg.drop == DropPolicy::Newest) continue;
+            if (m_cfg.drop == DropPolicy::Disconnect) { s->closed = true; continue; }
+            s->queue.pop_front();
+        }
+        s->queue.push_back(line);
+    }
+}
+
+// =============================================================================
+//  配信スレッド: 接続受付 / 切断検出 / batch_ms ごとのまとめ書き
+//  m_subs の追加・削除はこのスレッドのみ (publish() は要素の queue だけを触る)
+// =============================================================================
+void ResultPublisher::io_loop() {
+    ThreadCpuScope cpu("publisher");
+    while (m_running) {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(m_listen, &rd);
+        socket_t max_fd = m_listen;
+        for (auto& s : m_subs) {
+            FD_SET(s->fd, &rd);
+            max_fd = std::max(max_fd, s->fd);
+        }
+        timeval tv{m_cfg.batch_ms / 1000, (m_cfg.batch_ms % 1000) * 1000};
+        int n = select((int)max_fd + 1, &rd, nullptr, nullptr, &tv);
+
+        if (n > 0 && FD_ISSET(m_listen, &rd)) accept_new();
+        // 購読者からの入力は読み捨て (0 バイト = 切断)
+        for (auto& s : m_subs) {
+            if (n <= 0 || !FD_ISSET(s->fd, &rd)) continue;
+            char buf[256];
+            auto r = recv(s->fd, buf, sizeof(buf), 0);
+            if (r == 0 || (r < 0 && !would_block())) s->closed = true;
+        }
+        for (auto& s : m_subs)
+            if (!s->closed) flush(*s);
+
+        // 切断された購読者を削除
+        std::lock_guard<std::mutex> lk(m_mtx);
+        auto it = std::remove_if(m_subs.begin(), m_subs.end(), [&](const auto& s) {
+            if (!s->closed) return false;
+            close_socket(s->fd);
+            log_info("Publish") << "Subscriber disconnected";
+            return true;
+        });
+        m_subs.erase(it, m_subs.end());
+    }
+}
+
+void ResultPublisher::accept_new() {
+    socket_t fd = (socket_t)accept(m_listen, nullptr, nullptr);
+    if (fd == (socket_t)kInvalid) return;
+    set_nonblocking(fd);
+#if defined(SO_NOSIGPIPE)
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    auto s = std::make_unique<Subscriber>();
+    s->fd = fd;
+    std::lock_guard<std::mutex> lk(m_mtx);
+    m_subs.push_back(std::move(s));
+    log_info("Publish") << "Subscriber connected (" << m_subs.size() << " total)";
+}
+
+void ResultPublisher::flush(Subscriber& s) {
+    // 前回の残りを送り切ってから次のバッチを取り出す (行の途中で混ざらない)
+    if (s.pending.empty()) {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        for (size_t i = 0; i < m_cfg.batch_max && !s.queue.empty(); i++) {
+            s.pending += s.queue.front();
+            s.pending += '\n';
+            s.queue.pop_front();
+        }
+    }
+    while (!s.pending.empty()) {
+        auto r = send(s.fd, s.pending.data(), (int)s.pending.size(), kSendFlags);
+        if (r > 0) { s.pending.erase(0, (size_t)r); continue; }
+        if (r < 0 && would_block()) break;   // 購読者が遅い → 次の周期に続きを送る
+        s.closed = true;
+        break;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+// =============================================================================
+//  publisher.h - Unix ドメインソケットによるローカル配信 (publish/subscribe)
+//
+//  監視結果と状態遷移を JSON Lines でローカルの購読者に配信する。
+//  stdout をパイプで読む方式は、出力形式の変更で壊れ、読み手が遅いと
+//  書き込み側 (アプリ) が詰まる。ここでは:
+//    - publish() はキュー投入のみ (ワーカーを待たせない)
+//    - 購読者ごとに上限付きキュー。溢れたら drop ポリシーに従う
+//    - 送信は専用スレッドが batch_ms ごとにまとめて非ブロッキングで書く
+//  Windows は AF_UNIX (Windows 10 1803 以降) を使う。
+// =============================================================================
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class DropPolicy {
+    Oldest,       // 古いメッセージを捨てて新しいものを入れる
+    Newest,       // 新しいメッセージを捨てる
+    Disconnect,   // 購読者を切断する (再接続させる)
+};
+
+struct PublisherConfig {
+    std::string path;               // 空 = 無効
+    size_t queue_limit = 256;       // 購読者ごとのメッセージ数上限
+    int batch_ms = 100;             // 送信間隔 (この間のメッセージを 1 回で書く)
+    size_t batch_max = 64;          // 1 回の書き込みの最大メッセージ数
+    DropPolicy drop = DropPolicy::Oldest;
+
+    bool enabled() const { return !path.empty(); }
+};
+
+bool parse_drop_policy(const std::string& s, DropPolicy& out);
+
+// =============================================================================
+class ResultPublisher {
+public:
+    explicit ResultPublisher(const PublisherConfig& cfg);
+    ~ResultPublisher();
+
+    ResultPublisher(const ResultPublisher&) = delete;
+    ResultPublisher& operator=(const ResultPublisher&) = delete;
+
+    // ソケットを作成して配信スレッドを開始 (失敗時 false)
+    bool start();
+    void close();
+
+    // 1 行分 (改行なし) を全購読者のキューに入れる
+    void publish(const std::string& line);
+
+    size_t subscribers() const;
+    uint64_t published() const { return m_published.load(); }
+    uint64_t dropped() const { return m_dropped.load(); }
+
+private:
+#ifdef _WIN32
+    using socket_t = uintptr_t;
+#else
+    using socket_t = int;
+#endif
+    struct Subscriber {
+        socket_t fd;
+        std::deque<std::string> queue;
+        std::string pending;        // 送りきれなかったバイト列
+        std::atomic<bool> closed{false};
+    };
+
+    void io_loop();
+    void accept_new();
+    void flush(Subscriber& s);
+
+    PublisherConfig m_cfg;
+    socket_t m_listen;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    mutable std::mutex m_mtx;       // m_subs を保護
+    std::vector<std::unique_ptr<Subscriber>> m_subs;
+
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
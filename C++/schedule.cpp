@@ -0,0 +1,190 @@
+// =============================================================================
+//  schedule.cpp - 時間帯 / 曜日 / 日付による監視スケジュール
+// =============================================================================
+
+#include "schedule.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+using json = nlohmann::json;
+
+namespace {
+
+const char* const kDayNames[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+struct tm local_tm(std::time_t t) {
+    struct tm b;
+#ifdef _WIN32
+    localtime_s(&b, &t);
+#else
+    localtime_r(&t, &b);
+#endif
+    return b;
+}
+
+int day_index(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    for (int i = 0; i < 7; i++)
+        if (s.compare(0, 3, kDayNames[i]) == 0 && s.size() >= 3) return i;
+    return -1;
+}
+
+// "mon-fri", "sat,sun", "daily" / "*"、または ["mon", "tue"]
+bool parse_days(const json& j, uint8_t& mask) {
+    std::vector<std::string> items;
+    if (j.is_string()) {
+        std::string s = j.get<std::string>();
+        if (s == "daily" || s == "*") { mask = 0x7F; return true; }
+        std::stringstream ss(s);
+        std::string item;
+        while (std::getline(ss, item, ',')) items.push_back(item);
+    } else if (j.is_array()) {
+        for (const auto& d : j) {
+            if (!d.is_string()) return false;
+            items.push_back(d.get<std::string>());
+        }
+    } else {
+        return false;
+    }
+    mask = 0;
+    for (const auto& item : items) {
+        auto dash = item.find('-');
+        int a = day_index(item.substr(0, dash));
+        int b = (dash == std::string::npos) ? a : day_index(item.substr(dash + 1));
+        if (a < 0 || b < 0) return false;
+        for (int d = a;; d = (d + 1) % 7) {   // "fri-mon" のような折り返しも可
+            mask |= (uint8_t)(1 << d);
+            if (d == b) break;
+        }
+    }
+    return mask != 0;
+}
+
+// "HH:MM" → 分 ("24:00" 可)
+bool parse_hhmm(const json& j, int& minutes) {
+    if (!j.is_string()) return false;
+    int h = 0, m = 0;
+    if (std::sscanf(j.get<std::string>().c_str(), "%d:%d", &h, &m) != 2) return false;
+    if (h < 0 || m < 0 || m > 59 || h * 60 + m > 24 * 60) return false;
+    minutes = h * 60 + m;
+    return true;
+}
+
+bool parse_date(const json& j, int& yyyymmdd) {
+    if (!j.is_string()) return false;
+    int y = 0, mo = 0, d = 0;
+    if (std::sscanf(j.get<std::string>().c_str(), "%d-%d-%d", &y, &mo, &d) != 3) return false;
+    if (mo < 1 || mo > 12 || d < 1 || d > 31) return false;
+    yyyymmdd = y * 10000 + mo * 100 + d;
+    return true;
+}
+
+int date_of(const struct tm& b) {
+    return (b.tm_year + 1900) * 10000 + (b.tm_mon + 1) * 100 + b.tm_mday;
+}
+
+} // namespace
+
+// =============================================================================
+bool MonitorSchedule::parse(const json& rules, std::string& error) {
+    m_rules.clear();
+    if (!rules.is_array()) { error = "schedule must be an array of rules"; return false; }
+    for (size_t i = 0; i < rules.size(); i++) {
+        const auto& r = rules[i];
+        const std::string where = "schedule[" + std::to_string(i) + "]: ";
+        if (!r.is_object()) { error = where + "rule must be an object"; return false; }
+        ScheduleRule rule;
+        if (r.contains("days") && !parse_days(r["days"], rule.days)) {
+            error = where + "bad days " + r["days"].dump(); return false;
+        }
+        if (r.contains("dates")) {
+            if (!r["dates"].is_array()) { error = where + "dates must be an array"; return false; }
+            for (const auto& d : r["dates"]) {
+                int v;
+                if (!parse_date(d, v)) { error = where + "bad date " + d.dump(); return false; }
+                rule.dates.push_back(v);
+            }
+        }
+        if (r.contains("from") && !parse_hhmm(r["from"], rule.from_min)) {
+            error = where + "bad from " + r["from"].dump(); return false;
+        }
+        if (r.contains("to") && !parse_hhmm(r["to"], rule.to_min)) {
+            error = where + "bad to " + r["to"].dump(); return false;
+        }
+        rule.pause = r.value("pause", false);
+        rule.cooldown_ms = r.value("cooldown_ms", -1);
+        if (r.contains("cooldown_ms") && rule.cooldown_ms < 0) {
+            error = where + "cooldown_ms must be >= 0"; return false;
+        }
+        rule.label = r.value("label", "rule" + std::to_string(i + 1));
+        m_rules.push_back(std::move(rule));
+    }
+    return true;
+}
+
+int MonitorSchedule::match(int yyyymmdd, int wday, int minute) const {
+    for (size_t i = 0; i < m_rules.size(); i++) {
+        const auto& r = m_rules[i];
+        if (!r.dates.empty()) {
+            if (std::find(r.dates.begin(), r.dates.end(), yyyymmdd) == r.dates.end()) continue;
+        } else if (!(r.days & (1 << wday))) {
+            continue;
+        }
+        const bool in = (r.from_min <= r.to_min)
+            ? (minute >= r.from_min && minute < r.to_min)
+            : (minute >= r.from_min || minute < r.to_min);   // 日跨ぎ
+        if (in) return (int)i;
+    }
+    return -1;
+}
+
+// =============================================================================
+ScheduleState MonitorSchedule::evaluate(std::chrono::system_clock::time_point now) const {
+    ScheduleState st;
+    const std::time_t t = std::chrono::system_clock::to_time_t(now);
+    struct tm b = local_tm(t);
+
+    int minute = b.tm_hour * 60 + b.tm_min;
+    int date = date_of(b), wday = b.tm_wday;
+    const int current = match(date, wday, minute);
+    if (current >= 0) {
+        const auto& r = m_rules[current];
+        st.active = !r.pause;
+        st.cooldown_ms = r.cooldown_ms;
+        st.label = r.label;
+    }
+
+    // 分単位で先へ進め、一致するルールが変わる最初の時刻を探す
+    // (日付が変わるときだけ mktime で翌日の曜日/日付を求める)
+    const std::time_t minute_start = t - b.tm_sec;
+    struct tm day = b;
+    for (int k = 1; k <= 8 * 24 * 60; k++) {
+        if (++minute == 24 * 60) {
+            minute = 0;
+            day.tm_mday += 1;
+            day.tm_hour = 12;      // DST 切り替えで日付がずれないように
+            day.tm_isdst = -1;
+            std::mktime(&day);
+            date = date_of(day);
+            wday = day.tm_wday;
+        }
+        if (match(date, wday, minute) != current) {
+            st.next_change = std::chrono::system_clock::from_time_t(minute_start + (std::time_t)k * 60);
+            return st;
+        }
+    }
+    st.next_change = now + std::chrono::hours(24);
+    return st;
+}
+
+std::string format_schedule_time(std::chrono::system_clock::time_point t) {
+    struct tm b = local_tm(std::chrono::system_clock::to_time_t(t));
+    std::ostringstream o;
+    o << std::put_time(&b, "%a %H:%M");
+    return o.str();
+}
@@ -0,0 +1,64 @@
+#pragma once
+// =============================================================================
+//  schedule.h - 時間帯 / 曜日 / 日付による監視スケジュール
+//
+//  営業時間中は短い cooldown、夜間は長い cooldown、定休日は停止、のように
+//  回答が必要な時間帯に合わせてデバイスを使い、夜間の発熱と電力を下げる。
+//
+//  ルールは上から順に評価し、最初に一致したものを使う (一致なし = 既定の cooldown):
+//    "schedule": [
+//      {"dates": ["2026-12-25"], "pause": true, "label": "holiday"},
+//      {"days": "mon-sat", "from": "09:00", "to": "21:00", "cooldown_ms": 10000, "label": "open"},
+//      {"from": "21:00", "to": "09:00", "cooldown_ms": 300000, "label": "night"},
+//      {"days": "sun", "pause": true}
+//    ]
+//  days / dates は現在の日付で判定する (from > to は日跨ぎ。翌朝側も当日の曜日で見る)。
+//  評価は状態が変わる時刻にだけ行う (next_change まで再計算しない)。
+// =============================================================================
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// =============================================================================
+struct ScheduleRule {
+    uint8_t days = 0x7F;            // bit0 = 日曜 ... bit6 = 土曜
+    std::vector<int> dates;         // YYYYMMDD (指定時は曜日より優先)
+    int from_min = 0;               // [from, to) 分 (0..1440)
+    int to_min = 24 * 60;
+    bool pause = false;
+    int cooldown_ms = -1;           // -1 = 既定の cooldown
+    std::string label;
+};
+
+struct ScheduleState {
+    bool active = true;
+    int cooldown_ms = -1;           // -1 = 既定の cooldown
+    std::string label;              // 一致したルール (なしなら空)
+    std::chrono::system_clock::time_point next_change{};   // 次に状態が変わる時刻
+};
+
+// =============================================================================
+class MonitorSchedule {
+public:
+    // ルールの配列を解析 (エラー時は false と error)
+    bool parse(const nlohmann::json& rules, std::string& error);
+
+    bool enabled() const { return !m_rules.empty(); }
+    size_t size() const { return m_rules.size(); }
+
+    // now の状態と、次に状態が変わる時刻 (最大 8 日先まで探索)
+    ScheduleState evaluate(std::chrono::system_clock::time_point now) const;
+
+private:
+    // 一致したルールの番号 (なしなら -1)
+    int match(int yyyymmdd, int wday, int minute) const;
+
+    std::vector<ScheduleRule> m_rules;
+};
+
+// 表示用 "Mon 09:00"
+std::string format_schedule_time(std::chrono::system_clock::time_point t);
@@ -0,0 +1,178 @@
+// =============================================================================
+//  soak.cpp - 長時間連続稼働 (ソーク) テスト
+// =============================================================================
+
+#include "soak.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#endif
+
+// =============================================================================
+ProcessUsage sample_process_usage() {
+    ProcessUsage u;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        u.rss_mb = pmc.WorkingSetSize / (1024.0 * 1024.0);
+    DWORD hc = 0;
+    if (GetProcessHandleCount(GetCurrentProcess(), &hc)) u.handles = (int)hc;
+#else
+    std::ifstream f("/proc/self/statm");
+    long pages_total = 0, pages_rss = 0;
+    if (f >> pages_total >> pages_rss)
+        u.rss_mb = pages_rss * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+    std::error_code ec;
+    int n = 0;
+    for (std::filesystem::directory_iterator it("/proc/self/fd", ec), end;
+         !ec && it != end; it.increment(ec))
+        n++;
+    if (!ec) u.handles = n;
+#endif
+    return u;
+}
+
+// =============================================================================
+SoakMonitor::SoakMonitor(const SoakConfig& cfg)
+    : m_cfg(cfg),
+      m_start(std::chrono::steady_clock::now()),
+      m_last_report(m_start)
+{
+    m_base_usage = m_usage = m_peak_usage = sample_process_usage();
+}
+
+double SoakMonitor::elapsed_s() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+double SoakMonitor::mean(const std::vector<double>& v) {
+    return v.empty() ? 0.0 : std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+}
+
+void SoakMonitor::record_cycle(double latency_s, bool error, bool injected,
+                               uint64_t generator_recreates) {
+    m_cycles++;
+    // 注入したエラーはリカバリー経路の検証用なので、エラー率とは別に数える
+    if (error && injected) m_injected++;
+    else if (error) m_errors++;
+    m_recreates = generator_recreates - m_recreates_base;
+
+    m_usage = sample_process_usage();
+    m_peak_usage.rss_mb  = std::max(m_peak_usage.rss_mb, m_usage.rss_mb);
+    m_peak_usage.handles = std::max(m_peak_usage.handles, m_usage.handles);
+
+    // ウォームアップ中はモデルロード直後の揺らぎを基準に含めない
+    if (m_cycles <= (uint64_t)m_cfg.warmup_cycles) {
+        m_recreates_base = generator_recreates;
+        m_recreates = 0;
+        m_base_usage = m_usage;
+        return;
+    }
+    if (error) return;   // エラー応答のレイテンシはドリフト判定に使わない
+
+    if (m_base_window.size() < (size_t)m_cfg.window_cycles) {
+        m_base_window.push_back(latency_s);
+    }
+    m_recent_window.push_back(latency_s);
+    while (m_recent_window.size() > (size_t)m_cfg.window_cycles)
+        m_recent_window.pop_front();
+
+    double x = elapsed_s() / 3600.0;
+    double y = latency_s * 1000.0;
+    m_sx += x; m_sy += y; m_sxx += x * x; m_sxy += x * y; m_n++;
+}
+
+double SoakMonitor::latency_slope_ms_per_h() const {
+    if (m_n < 2) return 0.0;
+    double den = m_n * m_sxx - m_sx * m_sx;
+    return den > 0.0 ? (m_n * m_sxy - m_sx * m_sy) / den : 0.0;
+}
+
+bool SoakMonitor::finished() const {
+    return elapsed_s() >= m_cfg.duration_min * 60.0;
+}
+
+bool SoakMonitor::report_due() const {
+    return std::chrono::steady_clock::now() - m_last_report
+           >= std::chrono::seconds(m_cfg.report_interval_s);
+}
+
+std::string SoakMonitor::report() {
+    m_last_report = std::chrono::steady_clock::now();
+    std::vector<double> recent(m_recent_window.begin(), m_recent_window.end());
+
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(2)
+      << "[Soak] t=" << elapsed_s() / 60.0 << "min"
+      << "  cycles=" << m_cycles
+      << "  errors=" << m_errors
+      << "  injected=" << m_injected
+      << "  recreates=" << m_recreates
+      << "  lat_base=" << mean(m_base_window) << "s"
+      << "  lat_recent=" << mean(recent) << "s"
+      << "  slope=" << latency_slope_ms_per_h() << "ms/h"
+      << "  rss=" << m_usage.rss_mb << "MB"
+      << "  handles=" << m_usage.handles;
+    return o.str();
+}
+
+bool SoakMonitor::passed(std::string& summary) const {
+    std::vector<double> recent(m_recent_window.begin(), m_recent_window.end());
+    double base = mean(m_base_window);
+    double drift = base > 0.0 ? mean(recent) / base - 1.0 : 0.0;
+    double rss_growth = (m_usage.rss_mb >= 0 && m_base_usage.rss_mb >= 0)
+                        ? m_usage.rss_mb - m_base_usage.rss_mb : 0.0;
+    int handle_growth = (m_usage.handles >= 0 && m_base_usage.handles >= 0)
+                        ? m_usage.handles - m_base_usage.handles : 0;
+    double error_rate = m_cycles ? (double)m_errors / m_cycles : 0.0;
+
+    std::vector<std::string> fails;
+    if (m_cycles <= (uint64_t)m_cfg.warmup_cycles)
+        fails.push_back("not enough cycles");
+    if (drift > m_cfg.max_latency_drift)
+        fails.push_back("latency drift");
+    if (rss_growth > m_cfg.max_rss_growth_mb)
+        fails.push_back("RSS growth");
+    if (handle_growth > m_cfg.max_handle_growth)
+        fails.push_back("handle growth");
+    if (m_recreates > m_cfg.max_recreates)
+        fails.push_back("generator recreates");
+    if (error_rate > m_cfg.max_error_rate)
+        fails.push_back("error rate");
+
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(2)
+      << "[Soak] " << (fails.empty() ? "PASS" : "FAIL")
+      << "  duration=" << elapsed_s() / 60.0 << "min"
+      << "  cycles=" << m_cycles
+      << "\n  latency drift:  " << drift * 100.0 << "% (limit "
+      << m_cfg.max_latency_drift * 100.0 << "%), slope "
+      << latency_slope_ms_per_h() << " ms/h"
+      << "\n  RSS growth:     " << rss_growth << " MB (limit "
+      << m_cfg.max_rss_growth_mb << " MB), peak " << m_peak_usage.rss_mb << " MB"
+      << "\n  handle growth:  " << handle_growth << " (limit "
+      << m_cfg.max_handle_growth << ")"
+      << "\n  recreates:      " << m_recreates << " (limit "
+      << m_cfg.max_recreates << ")"
+      << "\n  error rate:     " << error_rate * 100.0 << "% (limit "
+      << m_cfg.max_error_rate * 100.0 << "%), " << m_injected << " injected faults excluded";
+    for (const auto& f : fails) o << "\n  FAILED: " << f;
+    summary = o.str();
+    return fails.empty();
+}
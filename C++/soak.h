@@ -0,0 +1,78 @@
+#pragma once
+// =============================================================================
+//  soak.h - 長時間連続稼働 (ソーク) テスト
+//
+//  監視ループを数時間〜数日回し、以下のドリフトを検出する:
+//    - 推論レイテンシの増加 (ウォームアップ後の基準窓 vs 直近窓, 傾き)
+//    - RSS の増加 (メモリリーク)
+//    - オープンハンドル数の増加 (fd / HANDLE リーク)
+//    - Generator 再作成回数 (エラーリカバリーの頻度)
+//  閾値を超えた場合は FAIL とし、終了コードで通知する。
+// =============================================================================
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// =============================================================================
+struct SoakConfig {
+    double duration_min = 0.0;        // 0 = ソーク無効
+    int report_interval_s = 60;       // 途中経過の出力間隔
+    int warmup_cycles = 20;           // 基準値取得前に捨てるサイクル数
+    int window_cycles = 50;           // 基準窓 / 直近窓のサイクル数
+    double max_latency_drift = 0.25;  // 直近窓平均 / 基準窓平均 - 1
+    double max_rss_growth_mb = 64.0;
+    int max_handle_growth = 16;
+    uint64_t max_recreates = 100;     // Generator 再作成回数の上限
+    double max_error_rate = 0.05;     // エラー応答の割合 (擬似エラーの注入分は除く)
+
+    bool enabled() const { return duration_min > 0.0; }
+};
+
+// プロセス資源 (取得できない項目は -1)
+struct ProcessUsage {
+    double rss_mb = -1.0;
+    int handles = -1;
+};
+ProcessUsage sample_process_usage();
+
+// =============================================================================
+class SoakMonitor {
+public:
+    explicit SoakMonitor(const SoakConfig& cfg);
+
+    // 1 推論サイクルの結果を記録 (injected: --fault-rate で注入したエラー)
+    void record_cycle(double latency_s, bool error, bool injected, uint64_t generator_recreates);
+
+    bool finished() const;              // duration_min 経過
+    bool report_due() const;            // 途中経過の出力時刻
+    std::string report();               // 途中経過 (report_due をリセット)
+    bool passed(std::string& summary) const;
+
+private:
+    double elapsed_s() const;
+    double latency_slope_ms_per_h() const;
+    static double mean(const std::vector<double>& v);
+
+    SoakConfig m_cfg;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_last_report;
+
+    uint64_t m_cycles = 0;
+    uint64_t m_errors = 0;             // 注入分を除く
+    uint64_t m_injected = 0;
+    uint64_t m_recreates_base = 0;
+    uint64_t m_recreates = 0;
+
+    std::vector<double> m_base_window;  // ウォームアップ直後の latency
+    std::deque<double> m_recent_window; // 直近の latency
+    ProcessUsage m_base_usage;
+    ProcessUsage m_usage;
+    ProcessUsage m_peak_usage;
+
+    // 傾き算出用の線形回帰の累積和 (全サイクルを保持しない)
+    double m_sx = 0, m_sy = 0, m_sxx = 0, m_sxy = 0;
+    uint64_t m_n = 0;
+};
@@ -0,0 +1,107 @@
+// =============================================================================
+//  telemetry.cpp - デバイステレメトリ (温度/消費電力) と熱スケジューラ
+// =============================================================================
+
+#include "telemetry.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "hailo/hailort.hpp"
+#include "hailo/vdevice.hpp"
+#include "hailo/device.hpp"
+
+// =============================================================================
+HailoTelemetrySource::HailoTelemetrySource(std::shared_ptr<hailort::VDevice> vdevice)
+    : m_vdevice(std::move(vdevice))
+{
+    if (!m_vdevice) return;
+    auto devs = m_vdevice->get_physical_devices();
+    if (devs && !devs.value().empty()) {
+        m_device = &devs.value()[0].get();
+    } else {
+        log_warn("Telemetry") << "Physical device not accessible - telemetry disabled.";
+    }
+}
+
+TelemetrySample HailoTelemetrySource::read(double) {
+    TelemetrySample s;
+    if (!m_device) return s;
+
+    if (m_temp_supported) {
+        auto t = m_device->get_chip_temperature();
+        if (t) {
+            s.temperature_c = std::max(t.value().ts0_temperature,
+                                       t.value().ts1_temperature);
+        } else {
+            m_temp_supported = false;
+            log_warn("Telemetry").field("status", (int)t.status())
+                << "Temperature not supported";
+        }
+    }
+    if (m_power_supported) {
+        auto p = m_device->power_measurement(HAILO_DVM_OPTIONS_AUTO,
+                                             HAILO_POWER_MEASUREMENT_TYPES__AUTO);
+        if (p) {
+            s.power_w = p.value();
+        } else {
+            m_power_supported = false;
+            log_warn("Telemetry").field("status", (int)p.status())
+                << "Power measurement not supported";
+        }
+    }
+    return s;
+}
+
+// =============================================================================
+SimulatedTelemetrySource::SimulatedTelemetrySource(float ambient_c, float max_c,
+                                                   double tau_heat_s, double tau_cool_s)
+    : m_ambient_c(ambient_c), m_max_c(max_c),
+      m_tau_heat_s(tau_heat_s), m_tau_cool_s(tau_cool_s),
+      m_temp_c(ambient_c)
+{}
+
+TelemetrySample SimulatedTelemetrySource::read(double duty_cycle) {
+    double now = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    double duty = std::clamp(duty_cycle, 0.0, 1.0);
+
+    if (m_last_s) {
+        double dt = now - *m_last_s;
+        double heat = (m_max_c - m_temp_c) * duty / m_tau_heat_s;
+        double cool = (m_temp_c - m_ambient_c) * (1.0 - duty) / m_tau_cool_s;
+        m_temp_c += dt * (heat - cool);
+        m_temp_c = std::clamp(m_temp_c, (double)m_ambient_c, (double)m_max_c);
+    }
+    m_last_s = now;
+
+    TelemetrySample s;
+    s.temperature_c = (float)m_temp_c;
+    s.power_w = (float)(1.5 + 6.0 * duty);   // アイドル 1.5W + 推論中 最大 7.5W
+    return s;
+}
+
+// =============================================================================
+double ThermalGovernor::update(const TelemetrySample& s) {
+    if (!s.temperature_c) return m_factor;
+
+    const double alpha = 0.3;
+    m_ema_c = m_ema_c ? (alpha * *s.temperature_c + (1.0 - alpha) * *m_ema_c)
+                      : (double)*s.temperature_c;
+
+    if (!m_cfg.enabled()) { m_factor = 1.0; m_throttling = false; return m_factor; }
+
+    // 減速中は傾斜の起点を解除温度まで下げる: 開始温度を超えた時点で倍率が
+    // 一段上がり、下がるときは解除温度でちょうど 1.0 に戻る (開始温度付近で振動しない)
+    const double start   = std::min(m_cfg.throttle_start_c, m_cfg.limit_c);
+    const double release = start - std::max(0.0f, m_cfg.hysteresis_c);
+    if (!m_throttling && *m_ema_c > start)         m_throttling = true;
+    else if (m_throttling && *m_ema_c <= release)  m_throttling = false;
+
+    const double base = m_throttling ? release : start;
+    double span  = std::max(1.0, (double)m_cfg.limit_c - base);
+    double x     = std::clamp((*m_ema_c - base) / span, 0.0, 1.0);
+    m_factor = 1.0 + (std::max(1.0, m_cfg.max_slowdown) - 1.0) * x;
+    return m_factor;
+}
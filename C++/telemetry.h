@@ -0,0 +1,115 @@
+#pragma once
+// =============================================================================
+//  telemetry.h - デバイステレメトリ (温度/消費電力) と熱スケジューラ
+//
+//  Hailo-10H は長時間の連続推論で過熱し、遅延増大やフリーズを起こす。
+//  TelemetrySource で温度を定期取得し、ThermalGovernor が熱予算に近づくほど
+//  監視推論の cooldown を滑らかに延長する (ハードな停止より段階的な減速)。
+//  実機がなくても SimulatedTelemetrySource で動作確認できる。
+// =============================================================================
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace hailort { class VDevice; class Device; }
+
+// =============================================================================
+struct TelemetrySample {
+    std::optional<float> temperature_c;
+    std::optional<float> power_w;
+};
+
+// =============================================================================
+struct ThermalConfig {
+    float throttle_start_c = 0.0f;   // 減速開始温度 (0 = 熱制御無効)
+    float limit_c = 0.0f;            // 熱予算 (この温度で減速率が最大)
+    float hysteresis_c = 3.0f;       // throttle_start_c からこれだけ下がるまで減速状態を解除しない
+    double max_slowdown = 8.0;       // limit_c 到達時の cooldown 倍率
+    double max_duty = 1.0;           // 推論時間の割合上限 (1.0 = 無制限)
+    int sample_interval_ms = 2000;   // テレメトリ取得間隔
+    bool simulate = false;           // 実機の代わりに熱モデルを使用
+
+    bool enabled() const { return limit_c > 0.0f; }
+};
+
+// =============================================================================
+class TelemetrySource {
+public:
+    virtual ~TelemetrySource() = default;
+
+    // duty_cycle: 直前のサンプリング区間で推論していた時間の割合 (0..1)
+    //             実機ソースは使用しない (シミュレーション用)
+    virtual TelemetrySample read(double duty_cycle) = 0;
+    virtual std::string name() const = 0;
+};
+
+// =============================================================================
+//  HailoTelemetrySource - VDevice 配下の物理デバイスから取得
+//
+//  ランタイムが対応していない項目 (電力センサーなし等) は最初の失敗以降
+//  問い合わせない。
+// =============================================================================
+class HailoTelemetrySource : public TelemetrySource {
+public:
+    explicit HailoTelemetrySource(std::shared_ptr<hailort::VDevice> vdevice);
+
+    TelemetrySample read(double duty_cycle) override;
+    std::string name() const override { return "hailo"; }
+
+private:
+    std::shared_ptr<hailort::VDevice> m_vdevice;
+    hailort::Device* m_device = nullptr;
+    bool m_temp_supported = true;
+    bool m_power_supported = true;
+};
+
+// =============================================================================
+//  SimulatedTelemetrySource - 一次遅れの熱モデル
+//
+//  dT/dt = (T_max - T) * duty / tau_heat - (T - T_amb) * (1 - duty) / tau_cool
+//  duty = 1 の連続推論で T_max に漸近する。
+// =============================================================================
+class SimulatedTelemetrySource : public TelemetrySource {
+public:
+    SimulatedTelemetrySource(float ambient_c = 40.0f, float max_c = 95.0f,
+                             double tau_heat_s = 90.0, double tau_cool_s = 60.0);
+
+    TelemetrySample read(double duty_cycle) override;
+    std::string name() const override { return "simulated"; }
+
+private:
+    float m_ambient_c;
+    float m_max_c;
+    double m_tau_heat_s;
+    double m_tau_cool_s;
+    double m_temp_c;
+    std::optional<double> m_last_s;
+};
+
+// =============================================================================
+//  ThermalGovernor - 温度から cooldown 倍率を算出
+//
+//  指数移動平均で平滑化した温度が throttle_start_c を超えると、
+//  limit_c に向かって 1.0 → max_slowdown へ線形に倍率を上げる。
+//  いったん減速すると倍率の起点を throttle_start_c - hysteresis_c に下げ、
+//  その温度まで下がるまで減速を続ける (開始温度付近での ON / OFF の繰り返しを防ぐ)。
+//  throttling() が true の間は倍率も 1.0 より大きい。
+// =============================================================================
+class ThermalGovernor {
+public:
+    explicit ThermalGovernor(const ThermalConfig& cfg) : m_cfg(cfg) {}
+
+    // 新しいサンプルを反映し、現在の cooldown 倍率を返す
+    double update(const TelemetrySample& s);
+
+    double factor() const { return m_factor; }
+    bool throttling() const { return m_throttling; }
+    std::optional<double> smoothed_temperature() const { return m_ema_c; }
+
+private:
+    ThermalConfig m_cfg;
+    std::optional<double> m_ema_c;
+    double m_factor = 1.0;
+    bool m_throttling = false;
+};
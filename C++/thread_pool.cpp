@@ -0,0 +1,51 @@
+// =============================================================================
+//  thread_pool.cpp - 固定スレッド数の共有エグゼキューター
+// =============================================================================
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+// =============================================================================
+ThreadPool::ThreadPool(size_t threads, const ThreadPolicy& policy, const std::string& name)
+    : m_policy(policy), m_name(name)
+{
+    threads = std::max<size_t>(1, threads);
+    for (size_t i = 0; i < threads; i++)
+        m_workers.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() { shutdown(); }
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_stopping) return;
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_workers)
+        if (t.joinable()) t.join();
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_tasks.size();
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    std::string name = m_name + "#" + std::to_string(index);
+    ThreadCpuScope cpu(name);
+    apply_thread_policy(m_policy, name);
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(m_mtx);
+            m_cv.wait(lk, [&] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) return;   // m_stopping かつキューが空
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();   // packaged_task が例外を future に格納する
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+// =============================================================================
+//  thread_pool.h - 固定スレッド数の共有エグゼキューター
+//
+//  カスタム推論・前処理・バックグラウンド書き込みで共用する。
+//  リクエストごとのスレッド生成をなくし、総スレッド数を固定する。
+// =============================================================================
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <string>
+#include <vector>
+
+#include "thread_util.h"
+
+class ThreadPool {
+public:
+    // policy: 全ワーカーに適用するコア固定/スケジューリング
+    explicit ThreadPool(size_t threads, const ThreadPolicy& policy = ThreadPolicy(),
+                        const std::string& name = "pool");
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <class F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto fut = task->get_future();
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            if (m_stopping) throw std::runtime_error("ThreadPool is shut down");
+            m_tasks.emplace_back([task] { (*task)(); });
+        }
+        m_cv.notify_one();
+        return fut;
+    }
+
+    // キュー内の残タスクを処理してからワーカーを終了
+    void shutdown();
+
+    size_t size() const { return m_workers.size(); }
+    size_t pending() const;
+
+private:
+    void worker_loop(size_t index);
+
+    std::vector<std::thread> m_workers;
+    ThreadPolicy m_policy;
+    std::string m_name;
+    std::deque<std::function<void()>> m_tasks;
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+};
@@ -0,0 +1,225 @@
+// =============================================================================
+//  thread_util.cpp - スレッドのコア割り当て / スケジューリング / CPU 時間
+// =============================================================================
+
+#include "thread_util.h"
+#include "logger.h"
+#include "trace.h"
+
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// =============================================================================
+std::vector<int> parse_core_list(const std::string& s) {
+    std::vector<int> cores;
+    std::istringstream in(s);
+    std::string tok;
+    while (std::getline(in, tok, ',')) {
+        if (tok.empty()) continue;
+        auto dash = tok.find('-');
+        if (dash == std::string::npos) {
+            cores.push_back(std::stoi(tok));
+        } else {
+            int a = std::stoi(tok.substr(0, dash));
+            int b = std::stoi(tok.substr(dash + 1));
+            for (int c = a; c <= b; c++) cores.push_back(c);
+        }
+    }
+    return cores;
+}
+
+bool parse_thread_policy(const std::string& s, ThreadPolicy& out, std::string& error) {
+    ThreadPolicy p;
+    auto slash = s.find('/');
+    try {
+        p.cores = parse_core_list(s.substr(0, slash));
+        if (slash != std::string::npos) {
+            std::string sched = s.substr(slash + 1);
+            auto colon = sched.find(':');
+            std::string kind = sched.substr(0, colon);
+            int value = (colon != std::string::npos) ? std::stoi(sched.substr(colon + 1)) : 0;
+            if (kind == "fifo")      p.fifo_priority = value > 0 ? value : 1;
+            else if (kind == "nice") p.nice = value;
+            else { error = "unknown scheduling class: " + kind + " (fifo|nice)"; return false; }
+        }
+    } catch (const std::exception&) {   // stoi: 数値でない
+        error = "bad number in \"" + s + "\"";
+        return false;
+    }
+    out = p;
+    return true;
+}
+
+// =============================================================================
+bool pin_current_thread(const std::vector<int>& cores) {
+    if (cores.empty()) return true;
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int c : cores)
+        if (c >= 0 && c < (int)(sizeof(DWORD_PTR) * 8)) mask |= (DWORD_PTR)1 << c;
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        log_warn("Thread") << "SetThreadAffinityMask failed";
+        return false;
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cores)
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        log_warn("Thread") << "pthread_setaffinity_np failed (" << rc << ")";
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool apply_thread_policy(const ThreadPolicy& policy, const std::string& name) {
+    if (policy.empty()) return true;
+    bool ok = pin_current_thread(policy.cores);
+
+#ifdef _WIN32
+    // Windows には SCHED_FIFO がないため優先度で近似
+    int prio = THREAD_PRIORITY_NORMAL;
+    if (policy.fifo_priority > 0)  prio = THREAD_PRIORITY_TIME_CRITICAL;
+    else if (policy.nice <= -10)   prio = THREAD_PRIORITY_HIGHEST;
+    else if (policy.nice < 0)      prio = THREAD_PRIORITY_ABOVE_NORMAL;
+    else if (policy.nice >= 10)    prio = THREAD_PRIORITY_LOWEST;
+    else if (policy.nice > 0)      prio = THREAD_PRIORITY_BELOW_NORMAL;
+    if (prio != THREAD_PRIORITY_NORMAL && !SetThreadPriority(GetCurrentThread(), prio)) {
+        log_warn("Thread") << name << ": SetThreadPriority failed";
+        ok = false;
+    }
+#else
+    if (policy.fifo_priority > 0) {
+        sched_param sp{};
+        sp.sched_priority = policy.fifo_priority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if (rc != 0) {
+            log_warn("Thread") << name << ": SCHED_FIFO not permitted ("
+                              << rc << "), keeping default policy";
+            ok = false;
+        }
+    } else if (policy.nice != 0) {
+        // Linux では nice 値はスレッド (tid) 単位
+        pid_t tid = (pid_t)syscall(SYS_gettid);
+        if (setpriority(PRIO_PROCESS, (id_t)tid, policy.nice) != 0) {
+            log_warn("Thread") << name << ": setpriority(" << policy.nice
+                              << ") not permitted";
+            ok = false;
+        }
+    }
+#endif
+    if (ok) log_info("Thread") << name << " policy applied";
+    else    log_warn("Thread") << name << " policy only partly applied";
+    return ok;
+}
+
+// =============================================================================
+//  CPU 時間レジストリ
+// =============================================================================
+namespace {
+
+struct CpuSlot {
+    std::string name;
+    bool alive = true;
+    double final_sec = 0.0;
+#ifdef _WIN32
+    HANDLE handle = nullptr;
+#else
+    clockid_t clock{};
+#endif
+};
+
+std::mutex g_cpu_mtx;
+std::vector<CpuSlot> g_cpu_slots;
+
+#ifdef _WIN32
+double handle_cpu_sec(HANDLE h) {
+    FILETIME c, e, k, u;
+    if (!GetThreadTimes(h, &c, &e, &k, &u)) return 0.0;
+    auto to100ns = [](const FILETIME& f) {
+        return ((unsigned long long)f.dwHighDateTime << 32) | f.dwLowDateTime;
+    };
+    return (to100ns(k) + to100ns(u)) * 1e-7;
+}
+#else
+double clock_cpu_sec(clockid_t clk) {
+    timespec ts{};
+    if (clock_gettime(clk, &ts) != 0) return 0.0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
+
+} // namespace
+
+double current_thread_cpu_sec() {
+#ifdef _WIN32
+    return handle_cpu_sec(GetCurrentThread());
+#else
+    return clock_cpu_sec(CLOCK_THREAD_CPUTIME_ID);
+#endif
+}
+
+ThreadCpuScope::ThreadCpuScope(const std::string& name) {
+    trace::set_thread_name(name);
+    CpuSlot slot;
+    slot.name = name;
+#ifdef _WIN32
+    DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(),
+                    &slot.handle, THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0);
+#else
+    pthread_getcpuclockid(pthread_self(), &slot.clock);
+#endif
+    std::lock_guard<std::mutex> lk(g_cpu_mtx);
+    m_slot = g_cpu_slots.size();
+    g_cpu_slots.push_back(slot);
+}
+
+ThreadCpuScope::~ThreadCpuScope() {
+    double sec = current_thread_cpu_sec();
+    std::lock_guard<std::mutex> lk(g_cpu_mtx);
+    auto& slot = g_cpu_slots[m_slot];
+    slot.final_sec = sec;
+    slot.alive = false;
+#ifdef _WIN32
+    if (slot.handle) CloseHandle(slot.handle);
+    slot.handle = nullptr;
+#endif
+}
+
+std::vector<std::pair<std::string, double>> thread_cpu_times() {
+    std::vector<std::pair<std::string, double>> out;
+    std::lock_guard<std::mutex> lk(g_cpu_mtx);
+    for (const auto& s : g_cpu_slots) {
+        double sec = s.final_sec;
+        if (s.alive) {
+#ifdef _WIN32
+            sec = s.handle ? handle_cpu_sec(s.handle) : 0.0;
+#else
+            sec = clock_cpu_sec(s.clock);
+#endif
+        }
+        out.emplace_back(s.name, sec);
+    }
+    return out;
+}
@@ -0,0 +1,59 @@
+#pragma once
+// =============================================================================
+//  thread_util.h - スレッドのコア割り当て / スケジューリング / CPU 時間 (Windows/Linux)
+//
+//  パイプラインの各スレッド (capture, worker, pool, telemetry) を
+//  指定コアに固定し、nice 値や SCHED_FIFO 優先度を設定する。
+//  CPU 時間はスレッドごとに登録し、stats() から参照できる。
+// =============================================================================
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// =============================================================================
+struct ThreadPolicy {
+    std::vector<int> cores;   // 空 = OS 任せ
+    int nice = 0;             // 0 = 変更なし (Windows では優先度クラスに換算)
+    int fifo_priority = 0;    // 1..99 で SCHED_FIFO (権限がなければ警告のみ)
+
+    bool empty() const { return cores.empty() && nice == 0 && fifo_priority == 0; }
+};
+
+// "0,2-3" → {0, 2, 3}  (空文字列 → 空)
+std::vector<int> parse_core_list(const std::string& s);
+
+// "<cores>[/fifo:<prio>|/nice:<n>]"  例: "1", "2-3/nice:5", "0/fifo:10"
+// 書式エラーなら false を返し error に理由を入れる
+bool parse_thread_policy(const std::string& s, ThreadPolicy& out, std::string& error);
+
+// 呼び出しスレッドを指定コアに固定 (空なら何もしない)
+bool pin_current_thread(const std::vector<int>& cores);
+
+// 呼び出しスレッドにポリシーを適用 (失敗した項目は警告して続行, すべて成功で true)
+bool apply_thread_policy(const ThreadPolicy& policy, const std::string& name);
+
+// =============================================================================
+//  スレッドごとの CPU 時間
+//
+//  スレッドの先頭で ThreadCpuScope を作ると、そのスレッドが登録される。
+//  終了後も最終値を保持する。
+// =============================================================================
+class ThreadCpuScope {
+public:
+    explicit ThreadCpuScope(const std::string& name);
+    ~ThreadCpuScope();
+
+    ThreadCpuScope(const ThreadCpuScope&) = delete;
+    ThreadCpuScope& operator=(const ThreadCpuScope&) = delete;
+
+private:
+    size_t m_slot;
+};
+
+// 呼び出しスレッドの CPU 時間 (秒)
+double current_thread_cpu_sec();
+
+// 登録済みスレッドの (名前, CPU 秒)
+std::vector<std::pair<std::string, double>> thread_cpu_times();
@@ -0,0 +1,161 @@
+// =============================================================================
+//  trace.cpp - パイプラインのスパン/カウンター記録 (Chrome trace-event JSON 出力)
+// =============================================================================
+
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+namespace {
+
+struct Event {
+    const char* name;
+    char ph;            // 'X' = 区間, 'C' = カウンター, 'i' = 瞬間
+    int64_t ts_us;
+    int64_t dur_us;
+    double value;
+};
+
+// スレッドごとのリングバッファ
+//   書き込みは所有スレッドのみ。mutex は dump() との排他用で通常は競合しない。
+struct ThreadBuffer {
+    std::mutex mtx;
+    std::vector<Event> events;
+    size_t next = 0;
+    bool wrapped = false;
+    uint32_t tid = 0;
+    std::string name;
+
+    void push(const Event& e) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (events.empty()) return;
+        events[next] = e;
+        if (++next == events.size()) { next = 0; wrapped = true; }
+    }
+};
+
+std::atomic<bool> g_enabled{false};
+std::atomic<size_t> g_capacity{65536};
+std::atomic<uint32_t> g_next_tid{1};
+
+std::mutex g_registry_mtx;
+std::vector<std::shared_ptr<ThreadBuffer>> g_registry;   // 終了したスレッド分も保持
+
+const auto g_epoch = std::chrono::steady_clock::now();
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+// バッファは最初の記録時に確保 (トレース無効時はメモリを使わない)
+thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+thread_local std::string t_name;
+
+ThreadBuffer& local_buffer() {
+    if (!t_buffer) {
+        auto b = std::make_shared<ThreadBuffer>();
+        b->events.resize(g_capacity.load());
+        b->tid = g_next_tid++;
+        b->name = t_name;
+        std::lock_guard<std::mutex> lk(g_registry_mtx);
+        g_registry.push_back(b);
+        t_buffer = std::move(b);
+    }
+    return *t_buffer;
+}
+
+void write_escaped(std::ostream& o, const std::string& s) {
+    for (char c : s) {
+        if (c == '"' || c == '\\') o << '\\';
+        o << c;
+    }
+}
+
+} // namespace
+
+// =============================================================================
+void enable(size_t events_per_thread) {
+    g_capacity = events_per_thread > 0 ? events_per_thread : 1;
+    g_enabled = true;
+}
+
+bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void set_thread_name(const std::string& name) {
+    t_name = name;
+    if (!t_buffer) return;
+    std::lock_guard<std::mutex> lk(t_buffer->mtx);
+    t_buffer->name = name;
+}
+
+void counter(const char* name, double value) {
+    local_buffer().push({name, 'C', now_us(), 0, value});
+}
+
+void instant(const char* name) {
+    local_buffer().push({name, 'i', now_us(), 0, 0.0});
+}
+
+Span::Span(const char* name)
+    : m_name(name), m_start_us(enabled() ? now_us() : -1)
+{}
+
+Span::~Span() {
+    if (m_start_us < 0) return;
+    int64_t end = now_us();
+    local_buffer().push({m_name, 'X', m_start_us, end - m_start_us, 0.0});
+}
+
+// =============================================================================
+bool dump(const std::string& path) {
+    std::ofstream o(path);
+    if (!o.is_open()) return false;
+
+    std::vector<std::shared_ptr<ThreadBuffer>> bufs;
+    {
+        std::lock_guard<std::mutex> lk(g_registry_mtx);
+        bufs = g_registry;
+    }
+
+    o << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto sep = [&] { if (!first) o << ",\n"; first = false; };
+
+    for (const auto& b : bufs) {
+        std::lock_guard<std::mutex> lk(b->mtx);
+        if (!b->name.empty()) {
+            sep();
+            o << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << b->tid
+              << ",\"args\":{\"name\":\"";
+            write_escaped(o, b->name);
+            o << "\"}}";
+        }
+        size_t n = b->wrapped ? b->events.size() : b->next;
+        size_t start = b->wrapped ? b->next : 0;
+        for (size_t k = 0; k < n; k++) {
+            const Event& e = b->events[(start + k) % b->events.size()];
+            sep();
+            o << "{\"name\":\"";
+            write_escaped(o, e.name);
+            o << "\",\"ph\":\"" << e.ph << "\",\"ts\":" << e.ts_us
+              << ",\"pid\":1,\"tid\":" << b->tid;
+            if (e.ph == 'X') o << ",\"dur\":" << e.dur_us;
+            else if (e.ph == 'C') o << ",\"args\":{\"value\":"
+                                    << (std::isfinite(e.value) ? e.value : 0.0) << "}";
+            else o << ",\"s\":\"t\"";
+            o << "}";
+        }
+    }
+    o << "]}\n";
+    return o.good();
+}
+
+} // namespace trace
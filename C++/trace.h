@@ -0,0 +1,63 @@
+#pragma once
+// =============================================================================
+//  trace.h - パイプラインのスパン/カウンター記録 (Chrome trace-event JSON 出力)
+//
+//  キャプチャ、update_frame、Worker 待機、前処理、generate、トークン読み取り、
+//  分類の時間的な重なりを chrome://tracing / Perfetto で可視化する。
+//
+//  - スレッドごとのリングバッファに記録 (書き込みはスレッド内で完結)
+//  - 実行時は --trace 指定時のみ記録 (未指定時は分岐 1 回のみ)
+//  - CMake の VLM_ENABLE_TRACE=OFF でマクロごと削除される
+// =============================================================================
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifndef VLM_ENABLE_TRACE
+#define VLM_ENABLE_TRACE 1
+#endif
+
+namespace trace {
+
+// 記録開始 (スレッドあたりのリングバッファ容量)
+void enable(size_t events_per_thread = 65536);
+bool enabled();
+
+// スレッド名 (トレースビューアのトラック名)
+void set_thread_name(const std::string& name);
+
+// name は文字列リテラル (ポインタのみ保持する)
+void counter(const char* name, double value);
+void instant(const char* name);
+
+// 全スレッドのバッファを Chrome trace-event JSON として書き出す
+bool dump(const std::string& path);
+
+class Span {
+public:
+    explicit Span(const char* name);
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_start_us;
+};
+
+} // namespace trace
+
+#define VLM_TRACE_CAT2(a, b) a##b
+#define VLM_TRACE_CAT(a, b) VLM_TRACE_CAT2(a, b)
+
+#if VLM_ENABLE_TRACE
+  #define VLM_TRACE_SCOPE(name)       trace::Span VLM_TRACE_CAT(trace_span_, __LINE__)(name)
+  #define VLM_TRACE_COUNTER(name, v)  do { if (trace::enabled()) trace::counter(name, (double)(v)); } while (0)
+  #define VLM_TRACE_INSTANT(name)     do { if (trace::enabled()) trace::instant(name); } while (0)
+#else
+  #define VLM_TRACE_SCOPE(name)       ((void)0)
+  #define VLM_TRACE_COUNTER(name, v)  ((void)0)
+  #define VLM_TRACE_INSTANT(name)     ((void)0)
+#endif
@@ -0,0 +1,219 @@
+// =============================================================================
+//  v4l2_capture.cpp - V4L2 直接キャプチャ (Linux, --v4l2)
+// =============================================================================
+
+#include "v4l2_capture.h"
+#include "logger.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// =============================================================================
+V4L2Capture::V4L2Capture(const V4L2Config& cfg) : m_cfg(cfg) {}
+
+V4L2Capture::~V4L2Capture() { release(); }
+
+std::string V4L2Capture::describe() const {
+    std::ostringstream o;
+    for (int i = 0; i < 4; i++) o << (char)((m_fourcc >> (8 * i)) & 0xFF);
+    o << " " << m_width << "x" << m_height << " @" << (int)(m_fps + 0.5) << "fps, "
+      << m_buffers.size() << " buffers";
+    return o.str();
+}
+
+double V4L2Capture::get(int prop) const {
+    switch (prop) {
+    case cv::CAP_PROP_FRAME_WIDTH:  return m_width;
+    case cv::CAP_PROP_FRAME_HEIGHT: return m_height;
+    case cv::CAP_PROP_FPS:          return m_fps;
+    case cv::CAP_PROP_FOURCC:       return m_fourcc;
+    case cv::CAP_PROP_BUFFERSIZE:   return (double)m_buffers.size();
+    default:                        return 0.0;
+    }
+}
+
+#ifdef __linux__
+
+bool V4L2Capture::xioctl(unsigned long request, void* arg) const {
+    int r;
+    do { r = ::ioctl(m_fd, request, arg); } while (r < 0 && errno == EINTR);
+    return r >= 0;
+}
+
+bool V4L2Capture::open_device(const std::string& path, int width, int height, int fps) {
+    release();
+    m_fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        log_error("V4L2") << path << ": " << std::strerror(errno);
+        return false;
+    }
+
+    // auto: 要求どおりのサイズと fps が出るなら YUYV (デコード不要)、出なければ MJPEG
+    const bool try_yuyv = m_cfg.format != "mjpeg";
+    const bool try_mjpeg = m_cfg.format != "yuyv";
+    bool ok = false;
+    if (try_yuyv && negotiate(V4L2_PIX_FMT_YUYV, width, height, fps))
+        ok = m_cfg.format == "yuyv" ||
+             (m_width == width && m_height == height && m_fps >= fps * 0.9);
+    if (!ok && try_mjpeg) ok = negotiate(V4L2_PIX_FMT_MJPEG, width, height, fps);
+    // MJPEG 非対応のカメラは、条件を満たさなくても YUYV で続ける
+    if (!ok && try_yuyv) ok = negotiate(V4L2_PIX_FMT_YUYV, width, height, fps);
+    if (!ok) {
+        log_error("V4L2") << path << ": no supported pixel format (" << m_cfg.format << ")";
+        release();
+        return false;
+    }
+    if (!start_streaming()) {
+        release();
+        return false;
+    }
+    log_info("V4L2") << path << ": " << describe();
+    return true;
+}
+
+bool V4L2Capture::negotiate(uint32_t fourcc, int width, int height, int fps) {
+    v4l2_format f{};
+    f.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    f.fmt.pix.width = (uint32_t)width;
+    f.fmt.pix.height = (uint32_t)height;
+    f.fmt.pix.pixelformat = fourcc;
+    f.fmt.pix.field = V4L2_FIELD_ANY;
+    // ドライバーは近い値に丸めて返す (形式が違えば非対応)
+    if (!xioctl(VIDIOC_S_FMT, &f) || f.fmt.pix.pixelformat != fourcc) return false;
+    m_fourcc = fourcc;
+    m_width = (int)f.fmt.pix.width;
+    m_height = (int)f.fmt.pix.height;
+    m_bytesperline = f.fmt.pix.bytesperline ? f.fmt.pix.bytesperline : f.fmt.pix.width * 2;
+
+    v4l2_streamparm p{};
+    p.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    p.parm.capture.timeperframe.numerator = 1;
+    p.parm.capture.timeperframe.denominator = (uint32_t)std::max(1, fps);
+    m_fps = fps;
+    if (xioctl(VIDIOC_S_PARM, &p) && p.parm.capture.timeperframe.numerator > 0)
+        m_fps = (double)p.parm.capture.timeperframe.denominator / p.parm.capture.timeperframe.numerator;
+    return true;
+}
+
+bool V4L2Capture::start_streaming() {
+    v4l2_requestbuffers req{};
+    req.count = (uint32_t)std::max(1, m_cfg.buffers);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (!xioctl(VIDIOC_REQBUFS, &req) || req.count == 0) {
+        log_error("V4L2") << "VIDIOC_REQBUFS failed: " << std::strerror(errno);
+        return false;
+    }
+    for (uint32_t i = 0; i < req.count; i++) {
+        v4l2_buffer b{};
+        b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        b.memory = V4L2_MEMORY_MMAP;
+        b.index = i;
+        if (!xioctl(VIDIOC_QUERYBUF, &b)) return false;
+        void* p = ::mmap(nullptr, b.length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, b.m.offset);
+        if (p == MAP_FAILED) {
+            log_error("V4L2") << "mmap failed: " << std::strerror(errno);
+            return false;
+        }
+        m_buffers.push_back({p, b.length});
+        if (!xioctl(VIDIOC_QBUF, &b)) return false;
+    }
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (!xioctl(VIDIOC_STREAMON, &type)) {
+        log_error("V4L2") << "VIDIOC_STREAMON failed: " << std::strerror(errno);
+        return false;
+    }
+    m_streaming = true;
+    return true;
+}
+
+void V4L2Capture::release() {
+    if (m_fd < 0) return;
+    if (m_streaming) {
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(VIDIOC_STREAMOFF, &type);
+        m_streaming = false;
+    }
+    for (auto& b : m_buffers) ::munmap(b.data, b.length);
+    m_buffers.clear();
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool V4L2Capture::read(cv::OutputArray image) {
+    if (!m_streaming) return false;
+    // 壊れたフレーム (MJPEG のデコード失敗など) は読み飛ばす
+    for (int attempt = 0; attempt < 4; attempt++) {
+        pollfd pfd{m_fd, POLLIN, 0};
+        int r = ::poll(&pfd, 1, 2000);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            log_warn("V4L2") << "No frame within 2 s";
+            return false;
+        }
+
+        // 溜まっているフレームをすべて取り出し、最新以外はすぐ返却する
+        v4l2_buffer latest{};
+        bool have = false;
+        for (;;) {
+            v4l2_buffer b{};
+            b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            b.memory = V4L2_MEMORY_MMAP;
+            if (!xioctl(VIDIOC_DQBUF, &b)) break;   // EAGAIN: 空
+            if (have) {
+                xioctl(VIDIOC_QBUF, &latest);
+                m_stale_dropped++;
+            }
+            latest = b;
+            have = true;
+        }
+        if (!have) continue;
+
+        bool ok = false;
+        if (!(latest.flags & V4L2_BUF_FLAG_ERROR) && latest.bytesused > 0) {
+            VLM_TRACE_SCOPE("v4l2_convert");
+            void* data = m_buffers[latest.index].data;
+            // mmap 上のデータを直接 BGR に変換 (中間コピーなし)
+            if (m_fourcc == V4L2_PIX_FMT_YUYV) {
+                if (latest.bytesused >= m_bytesperline * (uint32_t)m_height) {
+                    cv::Mat raw(m_height, m_width, CV_8UC2, data, m_bytesperline);
+                    cv::cvtColor(raw, image, cv::COLOR_YUV2BGR_YUYV);
+                    ok = true;
+                }
+            } else {
+                cv::Mat raw(1, (int)latest.bytesused, CV_8UC1, data);
+                cv::Mat bgr = cv::imdecode(raw, cv::IMREAD_COLOR);
+                if (!bgr.empty()) { image.assign(bgr); ok = true; }
+            }
+        }
+        xioctl(VIDIOC_QBUF, &latest);
+        if (ok) return true;
+    }
+    return false;
+}
+
+#else   // V4L2 は Linux のみ
+
+bool V4L2Capture::xioctl(unsigned long, void*) const { return false; }
+bool V4L2Capture::open_device(const std::string&, int, int, int) {
+    log_error("V4L2") << "--v4l2 is only supported on Linux.";
+    return false;
+}
+bool V4L2Capture::negotiate(uint32_t, int, int, int) { return false; }
+bool V4L2Capture::start_streaming() { return false; }
+void V4L2Capture::release() {}
+bool V4L2Capture::read(cv::OutputArray) { return false; }
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+// =============================================================================
+//  v4l2_capture.h - V4L2 直接キャプチャ (Linux, --v4l2)
+//
+//  cv::VideoCapture 経由では画素形式もバッファ数も選べず、ドライバーのキューに
+//  溜まった古いフレームを順に読むので遅延が積み重なる。ここでは:
+//    - 画素形式と解像度をドライバーと交渉 (auto: 要求サイズ / fps が出るなら
+//      YUYV、出なければ MJPEG。USB2 の帯域では高解像度 YUYV は fps が落ちる)
+//    - mmap バッファ (既定 2 枚) でキュー深さを抑え、read() では溜まっている
+//      フレームをすべて取り出して最新の 1 枚だけを使う (古いバッファは即返却)
+//    - mmap 上のデータから BGR へ 1 パスで変換 (YUYV は cvtColor、MJPEG は imdecode)
+//  cv::VideoCapture を継承するので、App からは通常のカメラと同じに扱える。
+// =============================================================================
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// =============================================================================
+struct V4L2Config {
+    std::string format = "auto";   // auto | yuyv | mjpeg
+    int buffers = 2;               // ドライバーのキュー深さ (少ないほど遅延が小さい)
+};
+
+class V4L2Capture : public cv::VideoCapture {
+public:
+    explicit V4L2Capture(const V4L2Config& cfg);
+    ~V4L2Capture() override;
+
+    // /dev/videoN を開き、width x height @ fps で交渉してストリーミングを開始
+    bool open_device(const std::string& path, int width, int height, int fps);
+
+    bool isOpened() const override { return m_streaming; }
+    void release() override;
+    bool read(cv::OutputArray image) override;
+    double get(int prop) const override;
+    bool set(int, double) override { return false; }   // 形式は open_device で確定
+
+    // 例: "MJPG 1280x720 @30fps, 2 buffers"
+    std::string describe() const;
+    uint64_t stale_dropped() const { return m_stale_dropped; }
+
+private:
+    struct Buffer {
+        void* data = nullptr;
+        size_t length = 0;
+    };
+    bool negotiate(uint32_t fourcc, int width, int height, int fps);
+    bool start_streaming();
+    bool xioctl(unsigned long request, void* arg) const;
+
+    V4L2Config m_cfg;
+    int m_fd = -1;
+    bool m_streaming = false;
+    std::vector<Buffer> m_buffers;
+    uint32_t m_fourcc = 0;
+    int m_width = 0, m_height = 0;
+    uint32_t m_bytesperline = 0;
+    double m_fps = 0.0;
+    uint64_t m_stale_dropped = 0;   // 最新でないため使わずに返却したフレーム
+};
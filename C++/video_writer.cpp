@@ -0,0 +1,139 @@
+// =============================================================================
+//  video_writer.cpp - 推論結果を重ねた出力動画の書き出し
+// =============================================================================
+
+#include "video_writer.h"
+#include "logger.h"
+#include "thread_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <filesystem>
+
+// =============================================================================
+AnnotatedVideoWriter::AnnotatedVideoWriter(const std::string& path, size_t max_queue)
+    : m_path(path), m_max_queue(std::max<size_t>(1, max_queue))
+{
+    m_thread = std::thread(&AnnotatedVideoWriter::writer_loop, this);
+}
+
+AnnotatedVideoWriter::~AnnotatedVideoWriter() { close(); }
+
+void AnnotatedVideoWriter::close() {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+
+    std::lock_guard<std::mutex> lk(m_mtx);
+    log_info("Output") << "Wrote " << m_written << " frames to " << m_path
+                       << " (dropped " << m_dropped << ")";
+}
+
+uint64_t AnnotatedVideoWriter::written() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_written;
+}
+
+uint64_t AnnotatedVideoWriter::dropped() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_dropped;
+}
+
+// =============================================================================
+void AnnotatedVideoWriter::set_overlay(const VideoOverlay& overlay) {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    m_overlay = overlay;
+}
+
+void AnnotatedVideoWriter::push(const cv::Mat& frame, double fps) {
+    if (frame.empty()) return;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_running) return;
+        if (m_queue.size() >= m_max_queue) { m_dropped++; return; }
+        m_queue.push_back({frame.clone(), m_overlay, fps});
+    }
+    m_cv.notify_one();
+}
+
+// =============================================================================
+void AnnotatedVideoWriter::writer_loop() {
+    ThreadCpuScope cpu("video_out");
+
+    cv::VideoWriter writer;
+    cv::Size size;
+    bool failed = false;
+
+    for (;;) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lk(m_mtx);
+            m_cv.wait(lk, [&] { return !m_running || !m_queue.empty(); });
+            if (m_queue.empty()) break;   // 停止要求 + キューが空
+            item = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        if (failed) continue;
+
+        VLM_TRACE_SCOPE("video_out");
+        if (!writer.isOpened()) {
+            std::string ext = std::filesystem::path(m_path).extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            int fourcc = (ext == ".avi") ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G')
+                                         : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+            size = cv::Size(item.frame.cols, item.frame.rows);
+            double fps = item.fps > 0 ? item.fps : 25.0;
+            if (!writer.open(m_path, fourcc, fps, size)) {
+                log_error("Output") << "Cannot open " << m_path;
+                failed = true;
+                continue;
+            }
+            log_info("Output") << "Writing annotated video: " << m_path << " ("
+                               << size.width << "x" << size.height << " @ " << fps << "fps)";
+        }
+        // プレイリスト内で解像度が変わる場合は最初のサイズに合わせる
+        if (item.frame.cols != size.width || item.frame.rows != size.height)
+            cv::resize(item.frame, item.frame, size);
+
+        draw_overlay(item.frame, item.overlay);
+        writer.write(item.frame);
+
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_written++;
+    }
+    writer.release();
+}
+
+// =============================================================================
+void AnnotatedVideoWriter::draw_overlay(cv::Mat& img, const VideoOverlay& ov) {
+    // 画面幅に応じて文字サイズを決める (640px で 0.6)
+    const double scale = std::max(0.4, img.cols / 640.0 * 0.6);
+    const int thick = std::max(1, (int)(scale * 2));
+    const int line_h = (int)(30 * scale / 0.6);
+    const int font = cv::FONT_HERSHEY_SIMPLEX;
+
+    std::string lines[3] = {
+        ov.category.empty() ? std::string("(waiting)") : ov.category,
+        ov.raw,
+        ov.latency.empty() ? ov.source : ov.latency + (ov.source.empty() ? "" : "  |  " + ov.source),
+    };
+
+    // 半透明の背景帯
+    int band_h = line_h * 3 + line_h / 2;
+    cv::Rect band(0, 0, img.cols, std::min(band_h, img.rows));
+    cv::Mat roi = img(band);
+    cv::Mat dark(roi.rows, roi.cols, roi.type(), cv::Scalar(0, 0, 0));
+    cv::addWeighted(dark, 0.55, roi, 0.45, 0.0, roi);
+
+    const cv::Scalar colors[3] = {
+        cv::Scalar(0, 255, 255), cv::Scalar(230, 230, 230), cv::Scalar(180, 255, 180)};
+    for (int i = 0; i < 3; i++) {
+        if (lines[i].empty()) continue;
+        cv::putText(img, lines[i], cv::Point(10, line_h * (i + 1)), font,
+                    i == 0 ? scale * 1.2 : scale, colors[i], thick, cv::LINE_AA);
+    }
+}
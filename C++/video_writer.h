@@ -0,0 +1,71 @@
+#pragma once
+// =============================================================================
+//  video_writer.h - 推論結果を重ねた出力動画の書き出し (オフライン解析用)
+//
+//  動画フォルダを再生しながら、現在の分類結果・生レスポンス・レイテンシを
+//  各フレームに描画して 1 本の動画に保存する。画面録画の代わりに使う。
+//
+//  - push() はコピーとキュー投入のみ (描画/エンコードは専用スレッド)
+//  - キューが満杯なら破棄して数える (推論/キャプチャを待たせない)
+// =============================================================================
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+
+// フレームに重ねる内容 (最新の監視結果)
+struct VideoOverlay {
+    std::string category;   // 分類結果
+    std::string raw;        // 生レスポンス (先頭のみ)
+    std::string latency;    // 例: "1.23s"
+    std::string source;     // 再生中のファイル名など
+};
+
+// =============================================================================
+class AnnotatedVideoWriter {
+public:
+    // path の拡張子で形式を選ぶ (.avi = MJPG, それ以外 = mp4v)
+    AnnotatedVideoWriter(const std::string& path, size_t max_queue = 32);
+    ~AnnotatedVideoWriter();
+
+    AnnotatedVideoWriter(const AnnotatedVideoWriter&) = delete;
+    AnnotatedVideoWriter& operator=(const AnnotatedVideoWriter&) = delete;
+
+    // fps は最初のフレームで出力に使う (以降のフレームサイズは最初に合わせる)
+    void push(const cv::Mat& frame, double fps);
+    void set_overlay(const VideoOverlay& overlay);
+
+    // 残りを書き出して終了
+    void close();
+
+    uint64_t written() const;
+    uint64_t dropped() const;
+
+private:
+    struct Item {
+        cv::Mat frame;
+        VideoOverlay overlay;
+        double fps;
+    };
+
+    void writer_loop();
+    static void draw_overlay(cv::Mat& img, const VideoOverlay& ov);
+
+    std::string m_path;
+    size_t m_max_queue;
+
+    std::thread m_thread;
+    bool m_running = true;
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<Item> m_queue;
+    VideoOverlay m_overlay;
+
+    uint64_t m_written = 0;
+    uint64_t m_dropped = 0;
+};
@@ -0,0 +1,316 @@
+// =============================================================================
+//  watch_folder.cpp - 静止画フォルダーの監視取り込み (--watch)
+// =============================================================================
+
+#include "watch_folder.h"
+#include "logger.h"
+#include "thread_util.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool is_image(const fs::path& p) {
+    const auto name = p.filename().string();
+    if (name.empty() || name[0] == '.') return false;   // 転送中の一時ファイル
+    auto ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png";
+}
+
+bool has_result(const std::string& path) {
+    std::error_code ec;
+    return fs::exists(path + ".json", ec);
+}
+
+// ヘッダーだけ読んで画像サイズを得る (JPEG の SOFn / PNG の IHDR)
+bool read_image_size(const std::string& path, int& w, int& h) {
+    std::ifstream f(path, std::ios::binary);
+    unsigned char b[24];
+    if (!f.read((char*)b, 24)) return false;
+    if (b[0] == 0x89 && b[1] == 'P' && b[2] == 'N' && b[3] == 'G') {
+        w = (b[16] << 24) | (b[17] << 16) | (b[18] << 8) | b[19];
+        h = (b[20] << 24) | (b[21] << 16) | (b[22] << 8) | b[23];
+        return w > 0 && h > 0;
+    }
+    if (b[0] != 0xFF || b[1] != 0xD8) return false;
+    f.seekg(2);
+    unsigned char m[9];
+    while (f.read((char*)m, 4)) {
+        if (m[0] != 0xFF) return false;
+        const int marker = m[1];
+        const int len = (m[2] << 8) | m[3];
+        // SOF0-SOF15 (DHT / JPG / DAC を除く)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (!f.read((char*)m, 5)) return false;
+            h = (m[1] << 8) | m[2];
+            w = (m[3] << 8) | m[4];
+            return w > 0 && h > 0;
+        }
+        if (len < 2) return false;
+        f.seekg(len - 2, std::ios::cur);
+    }
+    return false;
+}
+
+WatchItem decode_image(const std::string& path, int max_side) {
+    WatchItem item;
+    item.path = path;
+    // 長辺が max_side を下回らない範囲で最も小さい縮小率を選ぶ
+    // (JPEG はデコーダーが DCT 段階で縮小するので展開コストも下がる)
+    int flag = cv::IMREAD_COLOR;
+    int w = 0, h = 0;
+    if (max_side > 0 && read_image_size(path, w, h)) {
+        const int side = std::max(w, h);
+        if (side >= 8 * max_side)      flag = cv::IMREAD_REDUCED_COLOR_8;
+        else if (side >= 4 * max_side) flag = cv::IMREAD_REDUCED_COLOR_4;
+        else if (side >= 2 * max_side) flag = cv::IMREAD_REDUCED_COLOR_2;
+    }
+    try { item.image = cv::imread(path, flag); }
+    catch (const cv::Exception& e) { item.error = e.what(); }
+    if (item.image.empty() && item.error.empty()) item.error = "cannot decode";
+    return item;
+}
+
+} // namespace
+
+bool write_watch_result(const std::string& image_path, const nlohmann::json& result) {
+    const std::string path = image_path + ".json";
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp);
+        if (!f.is_open()) return false;
+        f << result.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) << "\n";
+        if (!f) return false;
+    }
+    // 読み手が書きかけの .json を見ないよう rename で置き換える
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) { fs::remove(tmp, ec); return false; }
+    return true;
+}
+
+// =============================================================================
+FolderWatcher::FolderWatcher(const WatchConfig& cfg, ThreadPool& pool)
+    : m_cfg(cfg), m_pool(pool)
+{
+    m_cfg.max_backlog = std::max<size_t>(1, m_cfg.max_backlog);
+    m_cfg.decode_ahead = std::max<size_t>(1, m_cfg.decode_ahead);
+}
+
+FolderWatcher::~FolderWatcher() { close(); }
+
+bool FolderWatcher::start() {
+    std::error_code ec;
+    if (!fs::is_directory(m_cfg.dir, ec)) {
+        log_error("Watch") << "Not a directory: " << m_cfg.dir;
+        return false;
+    }
+#ifndef _WIN32
+    // 監視を先に登録してからスキャンする (間に置かれたファイルを取りこぼさない)
+    if (m_cfg.poll_ms <= 0) {
+        m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotify_fd >= 0 &&
+            inotify_add_watch(m_inotify_fd, m_cfg.dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+            m_use_inotify = true;
+        } else {
+            log_warn("Watch") << "inotify unavailable, polling every 1000 ms";
+            if (m_inotify_fd >= 0) { ::close(m_inotify_fd); m_inotify_fd = -1; }
+        }
+    }
+#endif
+    if (!m_use_inotify && m_cfg.poll_ms <= 0) m_cfg.poll_ms = 1000;
+
+    m_running = true;
+    scan_pending();
+    log_info("Watch") << m_cfg.dir << ": " << backlog() << " pending, "
+                      << (m_use_inotify ? std::string("inotify")
+                                        : "polling every " + std::to_string(m_cfg.poll_ms) + " ms");
+    m_thread = std::thread(&FolderWatcher::watch_loop, this);
+    return true;
+}
+
+void FolderWatcher::close() {
+    m_running = false;
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+#ifndef _WIN32
+    if (m_inotify_fd >= 0) { ::close(m_inotify_fd); m_inotify_fd = -1; }
+#endif
+    // デコード中のタスクは this を参照しないので待たずに破棄してよい
+    std::lock_guard<std::mutex> lk(m_mtx);
+    m_decoding.clear();
+    m_paths.clear();
+}
+
+size_t FolderWatcher::backlog() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_paths.size() + m_decoding.size();
+}
+
+// =============================================================================
+void FolderWatcher::enqueue(const std::string& path) {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    if (m_known.count(path)) return;
+    if (m_paths.size() >= m_cfg.max_backlog) {
+        // 捨てずに後で拾い直す (結果の .json が無い限り再スキャンで見つかる)
+        if (!m_rescan) log_warn("Watch") << "Backlog full (" << m_cfg.max_backlog
+                                         << "), deferring new images";
+        m_rescan = true;
+        m_deferred++;
+        return;
+    }
+    m_paths.push_back(path);
+    m_known.insert(path);
+    m_detected++;
+    fill_decodes();
+    m_cv.notify_all();
+}
+
+void FolderWatcher::fill_decodes() {
+    while (m_decoding.size() < m_cfg.decode_ahead && !m_paths.empty()) {
+        std::string path = std::move(m_paths.front());
+        m_paths.pop_front();
+        const int max_side = m_cfg.max_side;
+        try {
+            m_decoding.push_back(m_pool.submit([path, max_side] {
+                return decode_image(path, max_side);
+            }));
+        } catch (const std::exception&) {
+            return;   // エグゼキューター停止中
+        }
+    }
+}
+
+void FolderWatcher::scan_pending() {
+    // 直近に更新されたファイルは書き込み中かもしれないので、inotify の完了通知か
+    // 定期スキャンの安定判定に任せる
+    const auto settled = fs::file_time_type::clock::now() - std::chrono::seconds(2);
+    std::vector<std::pair<fs::file_time_type, std::string>> found;
+    bool unsettled = false;
+    std::error_code ec;
+    for (fs::directory_iterator it(m_cfg.dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || !is_image(it->path())) continue;
+        const std::string path = it->path().string();
+        if (has_result(path)) continue;
+        const auto t = it->last_write_time(ec);
+        if (t > settled) { unsettled = true; continue; }
+        found.emplace_back(t, path);
+    }
+    std::sort(found.begin(), found.end());   // 古い順
+    {
+        // 書き込み中とみなして見送った画像は、安定判定の期間が過ぎてから拾い直す
+        // (起動直前に書かれた画像も inotify の通知が来ないのでここで拾う)
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_rescan = unsettled;
+        if (unsettled) m_rescan_at = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    }
+    for (const auto& [t, path] : found) enqueue(path);
+}
+
+bool FolderWatcher::next(WatchItem& out, std::chrono::milliseconds timeout) {
+    std::future<WatchItem> f;
+    {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        if (!m_cv.wait_for(lk, timeout, [&] { return !m_decoding.empty() || !m_running; }))
+            return false;
+        if (m_decoding.empty()) return false;
+        f = std::move(m_decoding.front());
+        m_decoding.pop_front();
+        fill_decodes();
+    }
+    try { out = f.get(); }
+    catch (const std::exception& e) { out = WatchItem{}; out.error = e.what(); }
+    return !out.path.empty();
+}
+
+void FolderWatcher::done(const std::string& path) {
+    // 結果を書けなかった画像は known に残し、再スキャンで同じ画像を繰り返さない
+    if (!has_result(path)) return;
+    std::lock_guard<std::mutex> lk(m_mtx);
+    m_known.erase(path);
+}
+
+// =============================================================================
+void FolderWatcher::watch_loop() {
+    ThreadCpuScope cpu("watch");
+
+    auto rescan_if_drained = [&] {
+        bool due;
+        {
+            std::lock_guard<std::mutex> lk(m_mtx);
+            due = m_rescan && m_paths.size() <= m_cfg.max_backlog / 2 &&
+                  std::chrono::steady_clock::now() >= m_rescan_at;
+        }
+        if (due) scan_pending();
+    };
+
+#ifndef _WIN32
+    if (m_use_inotify) {
+        alignas(inotify_event) char buf[4096];
+        while (m_running) {
+            pollfd pfd{m_inotify_fd, POLLIN, 0};
+            if (::poll(&pfd, 1, 200) > 0) {
+                ssize_t n;
+                while ((n = ::read(m_inotify_fd, buf, sizeof(buf))) > 0) {
+                    for (char* p = buf; p < buf + n; ) {
+                        auto* ev = reinterpret_cast<inotify_event*>(p);
+                        p += sizeof(inotify_event) + ev->len;
+                        if (ev->mask & IN_Q_OVERFLOW) {
+                            // カーネル側のイベントが溢れた: 次の機会に全体を拾い直す
+                            std::lock_guard<std::mutex> lk(m_mtx);
+                            m_rescan = true;
+                            continue;
+                        }
+                        if ((ev->mask & IN_ISDIR) || ev->len == 0) continue;
+                        fs::path path = fs::path(m_cfg.dir) / ev->name;
+                        if (is_image(path) && !has_result(path.string())) enqueue(path.string());
+                    }
+                }
+            }
+            rescan_if_drained();
+        }
+        return;
+    }
+#endif
+
+    // ---- 定期スキャン: サイズと更新時刻が 1 周期変わらなければ書き込み完了 ----
+    std::map<std::string, std::pair<uintmax_t, fs::file_time_type>> candidates;
+    while (m_running) {
+        std::map<std::string, std::pair<uintmax_t, fs::file_time_type>> seen;
+        std::vector<std::pair<fs::file_time_type, std::string>> ready;
+        std::error_code ec;
+        for (fs::directory_iterator it(m_cfg.dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec) || !is_image(it->path())) continue;
+            const std::string path = it->path().string();
+            if (has_result(path)) continue;
+            {
+                std::lock_guard<std::mutex> lk(m_mtx);
+                if (m_known.count(path) || m_paths.size() >= m_cfg.max_backlog) continue;
+            }
+            auto sig = std::make_pair(it->file_size(ec), it->last_write_time(ec));
+            auto c = candidates.find(path);
+            if (c != candidates.end() && c->second == sig) ready.emplace_back(sig.second, path);
+            else seen[path] = sig;
+        }
+        candidates = std::move(seen);
+        std::sort(ready.begin(), ready.end());   // 古い順
+        for (const auto& [t, path] : ready) enqueue(path);
+        rescan_if_drained();
+
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_cv.wait_for(lk, std::chrono::milliseconds(m_cfg.poll_ms), [&] { return !m_running; });
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+// =============================================================================
+//  watch_folder.h - 静止画フォルダーの監視取り込み (--watch)
+//
+//  他のシステム (監査用の端末など) がフォルダーに置いた JPEG / PNG を検出し、
+//  縮小デコードして監視パスで分類する。結果は画像の隣に <画像名>.json で書く。
+//
+//  - 検出: Linux は inotify (IN_CLOSE_WRITE / IN_MOVED_TO = 書き込み完了後のみ)。
+//    Windows、inotify が使えない場合、poll_ms > 0 (ネットワークドライブ向け) は
+//    定期スキャンで、サイズと更新時刻が 1 周期変わらなければ完了とみなす
+//  - デコード: 共有エグゼキューターで decode_ahead 枚まで先読み。JPEG は
+//    IMREAD_REDUCED_* で 1/2・1/4・1/8 のまま展開する (長辺 max_side 以上を保つ)
+//  - 待ち行列は max_backlog 件まで。溢れた分は捨てずに、空いたときの
+//    再スキャン (結果 .json のない画像を拾い直す) に任せる。起動時も同様
+// =============================================================================
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+#include <nlohmann/json.hpp>
+
+#include "frame_quality.h"
+#include "thread_pool.h"
+
+// =============================================================================
+struct WatchConfig {
+    std::string dir;            // 空 = 無効
+    size_t max_backlog = 256;   // 未処理として保持するパス数の上限
+    size_t decode_ahead = 4;    // 先読みデコードする枚数
+    int max_side = 1280;        // 縮小デコード後に保証する長辺 (px, 0 = 原寸)
+    int poll_ms = 0;            // > 0 で定期スキャンを強制 (Windows は 0 でも 1000)
+    QualityConfig quality;      // --quality-gate (watch では画像ごとに判定を記録するため
+                                //  Backend ではなく取り込み側で判定する)
+
+    bool enabled() const { return !dir.empty(); }
+};
+
+struct WatchItem {
+    std::string path;
+    cv::Mat image;        // BGR (デコード失敗時は空)
+    std::string error;
+};
+
+// 画像の隣に <path>.json を書く (一時ファイル → rename で置き換え)
+bool write_watch_result(const std::string& image_path, const nlohmann::json& result);
+
+// =============================================================================
+class FolderWatcher {
+public:
+    FolderWatcher(const WatchConfig& cfg, ThreadPool& pool);
+    ~FolderWatcher();
+
+    FolderWatcher(const FolderWatcher&) = delete;
+    FolderWatcher& operator=(const FolderWatcher&) = delete;
+
+    // 既存の未処理画像を積み、検出スレッドを開始 (失敗時 false)
+    bool start();
+    void close();
+
+    // デコード済みの次の画像 (timeout までに無ければ false)
+    bool next(WatchItem& out, std::chrono::milliseconds timeout);
+    // next() で受け取った画像の処理 (結果の書き込み) が終わったら呼ぶ
+    void done(const std::string& path);
+
+    size_t backlog() const;
+    uint64_t detected() const { return m_detected.load(); }
+    uint64_t deferred() const { return m_deferred.load(); }
+
+private:
+    void watch_loop();
+    void scan_pending();                       // 結果のない画像をすべて積む
+    void enqueue(const std::string& path);
+    void fill_decodes();                       // m_mtx 保持中に呼ぶ
+
+    WatchConfig m_cfg;
+    ThreadPool& m_pool;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    bool m_use_inotify = false;
+    int m_inotify_fd = -1;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<std::string> m_paths;           // 検出済み・未デコード
+    std::deque<std::future<WatchItem>> m_decoding;
+    std::set<std::string> m_known;             // 待ち行列 〜 done() までのパス
+    bool m_rescan = false;                     // 溢れた分 / 書き込み中だった分を拾い直す
+    std::chrono::steady_clock::time_point m_rescan_at{};   // これより前は再スキャンしない
+
+    std::atomic<uint64_t> m_detected{0};
+    std::atomic<uint64_t> m_deferred{0};
+};